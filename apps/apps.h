@@ -4,17 +4,36 @@
 #include <stdint.h>
 
 // --- Window Struct ---
+// Retained content surface, owned by the compositor
+typedef struct {
+    uint32_t* pixels;
+    uint32_t cap;
+    int w, h;
+    int dirty;
+    // Part that needs repainting when not fully dirty, in surface
+    // coordinates; empty when x1 <= x0
+    int dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+} WindowSurface;
+
 typedef struct {
     int x, y, w, h;
     int open, minimized, maximized;
     int old_x, old_y, old_w, old_h;
     char title[32];
+    WindowSurface surface;
 } Window;
 
+// Everything below the titlebar is cached in the window's surface
+#define WINDOW_TITLEBAR_H 20
+
 // --- Shared Graphics Functions (defined in kernel.c) ---
 extern uint32_t scr_width;
 extern uint32_t scr_height;
 extern int force_render_frame;
+void damage_window(Window* win);
+void window_invalidate(Window* win);
+// Repaint and present only a screen rect of the window's content
+void window_invalidate_rect(Window* win, int x, int y, int w, int h);
 
 void draw_pixel(int x, int y, uint32_t color);
 uint32_t get_pixel(int x, int y);
@@ -43,10 +62,11 @@ void calculate();
 
 // Notepad
 extern Window win_notepad;
-extern char notepad_buf[1024];
+extern char* notepad_buf;
 extern int notepad_len;
 void draw_notepad();
 void notepad_set_content(char* content, int len);
+void notepad_handle_key(char c);
 
 // Explorer
 extern Window win_explorer;
@@ -87,6 +107,7 @@ void draw_terminal();
 void terminal_handle_key(char key);
 void term_print(const char* s);
 void load_bex(uint8_t drive, const char* filename);
+void loader_init(void); // Reserve the fixed .bex load region
 
 // Browser
 extern Window win_browser;
@@ -1,16 +1,18 @@
 #include "apps.h"
 #include "../drivers/net.h"
+#include "../gfx/text.h"
+#include "../mm/kmalloc.h"
 #include <stddef.h>
 
 // --- Browser Window ---
-Window win_browser = {80, 60, 700, 450, 0, 0, 0, 80, 60, 700, 450, "Browser"};
+Window win_browser = {80, 60, 700, 450, 0, 0, 0, 80, 60, 700, 450, "Browser", {0}};
 
 // --- Browser State ---
 static char url_buf[128];
 static int url_len = 0;
 static int url_focused = 1;
 
-static uint8_t page_buf[HTTP_BUF_SIZE];
+static uint8_t* page_buf;   // HTTP_BUF_MAX bytes, taken on the first load
 static int page_len = 0;
 static int page_scroll = 0;
 static int browser_loading = 0;
@@ -76,15 +78,20 @@ static void browser_fetch(void) {
     }
 
     b_strcpy(status_msg, "Connecting...");
-    force_render_frame = 1;
+    window_invalidate(&win_browser);
     // Force a render so user sees "Connecting..."
     // (caller should trigger redraw)
 
     page_len = 0;
     page_scroll = 0;
+    if (!page_buf) page_buf = (uint8_t*)kmalloc(HTTP_BUF_MAX);
+    if (!page_buf) {
+        b_strcpy(status_msg, "Out of memory");
+        return;
+    }
     browser_loading = 1;
 
-    int result = net_http_get(host, path, page_buf, HTTP_BUF_SIZE);
+    int result = net_http_get(host, path, page_buf, HTTP_BUF_MAX);
 
     browser_loading = 0;
 
@@ -114,7 +121,7 @@ static void browser_fetch(void) {
         status_msg[si] = 0;
     }
 
-    force_render_frame = 1;
+    window_invalidate(&win_browser);
 }
 
 // --- Handle keyboard input for browser ---
@@ -129,17 +136,17 @@ void browser_handle_key(char c) {
         if (url_focused && url_len > 0) {
             url_len--;
             url_buf[url_len] = 0;
-            force_render_frame = 1;
+            window_invalidate(&win_browser);
         }
     } else if (c == '\t') {
         // Scroll down
         page_scroll += 5;
-        force_render_frame = 1;
+        window_invalidate(&win_browser);
     } else {
         if (url_focused && url_len < 126) {
             url_buf[url_len++] = c;
             url_buf[url_len] = 0;
-            force_render_frame = 1;
+            window_invalidate(&win_browser);
         }
     }
 }
@@ -148,7 +155,7 @@ void browser_handle_key(char c) {
 void browser_scroll(int direction) {
     page_scroll += direction * 3;
     if (page_scroll < 0) page_scroll = 0;
-    force_render_frame = 1;
+    window_invalidate(&win_browser);
 }
 
 // --- Draw the browser window ---
@@ -178,9 +185,7 @@ void draw_browser() {
     int max_url_chars = (bw - 52) / 8;
     int url_start = 0;
     if (url_len > max_url_chars) url_start = url_len - max_url_chars;
-    for (int i = url_start; i < url_len; i++) {
-        draw_char(url_buf[i], url_x + (i - url_start) * 8, url_bar_y + 6, 0xFFFFFF);
-    }
+    draw_text_run(url_buf + url_start, url_len - url_start, url_x, url_bar_y + 6, 0xFFFFFF);
     // Cursor
     if (url_focused) {
         int cursor_x = url_x + (url_len - url_start) * 8;
@@ -1,6 +1,6 @@
 #include "apps.h"
 
-Window win_calc = {100, 100, 200, 310, 0, 0, 0, 100, 100, 200, 310, "Calculator"};
+Window win_calc = {100, 100, 200, 310, 0, 0, 0, 100, 100, 200, 310, "Calculator", {0}};
 
 long calc_acc = 0;
 long calc_current = 0;
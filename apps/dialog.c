@@ -1,6 +1,6 @@
 #include "apps.h"
 
-Window win_dialog = {0, 0, 400, 200, 0, 0, 0, 0, 0, 400, 200, ""};
+Window win_dialog = {0, 0, 400, 200, 0, 0, 0, 0, 0, 400, 200, "", {0}};
 char custom_dialog_msg[128] = {0};
 
 void draw_dialog() {
@@ -2,11 +2,21 @@
 #include "../drivers/disk.h"
 #include "../drivers/fat16.h"
 #include "../drivers/fat32.h"
+#include "../mm/kmalloc.h"
 #include <stddef.h>
 
-Window win_explorer = {200, 200, 400, 300, 0, 0, 0, 200, 200, 400, 300, "Banana Files"};
+// Longer files still open, cut off at this many characters
+#define EXPLORER_TEXT_MAX 65536
 
-FAT32Entry file_entries[32]; 
+// The listing starts with room for this many entries and doubles while
+// the directory fills it, up to EXPLORER_LIST_MAX
+#define EXPLORER_LIST_MIN 32
+#define EXPLORER_LIST_MAX 4096
+
+Window win_explorer = {200, 200, 400, 300, 0, 0, 0, 200, 200, 400, 300, "Banana Files", {0}};
+
+FAT32Entry* file_entries = NULL;
+static int file_capacity = 0;
 int file_count = 0;
 int fs_type = 16; 
 int selected_drive = 0;
@@ -27,22 +37,41 @@ void explorer_init(uint8_t drive) {
     // Try FAT32 first
     if (fat32_init(drive)) {
         fs_type = 32;
-        file_count = fat32_list_root(file_entries, 32);
     } else {
         fat16_init(drive);
         fs_type = 16;
-        file_count = fat16_list_root((FAT16Entry*)file_entries, 32);
+    }
+
+    // The FAT listers stop when the array is full; a full array means
+    // there may be more, so grow it and list again
+    file_count = 0;
+    if (!file_capacity) {
+        file_entries = (FAT32Entry*)kmalloc(EXPLORER_LIST_MIN * sizeof(FAT32Entry));
+        if (!file_entries) return;
+        file_capacity = EXPLORER_LIST_MIN;
+    }
+    for (;;) {
+        if (fs_type == 32) file_count = fat32_list_root(file_entries, file_capacity);
+        else file_count = fat16_list_root((FAT16Entry*)file_entries, file_capacity);
+        if (file_count < file_capacity || file_capacity >= EXPLORER_LIST_MAX) break;
+
+        FAT32Entry* grown = (FAT32Entry*)krealloc(file_entries, file_capacity * 2 * sizeof(FAT32Entry));
+        if (!grown) break;
+        file_entries = grown;
+        file_capacity *= 2;
     }
 }
 
 void explorer_open_file(int index) {
     if (index < 0 || index >= file_count) return;
     
-    uint8_t temp_buf[1024]; 
     FAT32Entry* entry = &file_entries[index];
     if (entry->attr & 0x10) return; 
     
-    uint32_t read_size = (entry->size > 1024) ? 1024 : entry->size;
+    // The FAT readers always copy the whole file
+    uint8_t* temp_buf = (uint8_t*)kmalloc(entry->size ? entry->size : 1);
+    if (!temp_buf) return;
+    uint32_t read_size = (entry->size > EXPLORER_TEXT_MAX) ? EXPLORER_TEXT_MAX : entry->size;
     
     if (fs_type == 32) {
         fat32_init(selected_drive);
@@ -53,9 +82,10 @@ void explorer_open_file(int index) {
     }
     
     notepad_set_content((char*)temp_buf, read_size);
+    kfree(temp_buf);
     win_notepad.open = 1;
     win_notepad.minimized = 0;
-    force_render_frame = 1;
+    window_invalidate(&win_notepad);
 }
 
 void draw_explorer() {
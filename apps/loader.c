@@ -3,10 +3,24 @@
 #include "../drivers/disk.h"
 #include "../drivers/fat16.h"
 #include "../drivers/fat32.h"
+#include "../mm/pmm.h"
 
 extern void term_print(const char* s);
 extern void jmp_user(uint32_t entry, uint32_t stack);
 
+// .bex images are linked to run at BEX_LOAD_ADDR (see bex_sdk/bex.ld).
+// The image, its bss and the stack share one fixed region taken from the
+// page allocator at boot; the stack grows down from the region's top.
+#define BEX_LOAD_ADDR   0x2000000
+#define BEX_REGION_SIZE 0x800000
+#define BEX_STACK_SIZE  0x10000
+
+static int bex_region_ready = 0;
+
+void loader_init(void) {
+    bex_region_ready = pmm_claim(BEX_LOAD_ADDR, BEX_REGION_SIZE);
+}
+
 static void format_fat_name_loader(const char* raw, char* out) {
     int ni = 0;
     for (int k = 0; k < 8; k++) {
@@ -65,8 +79,16 @@ void load_bex(uint8_t drive, const char* filename) {
         term_print("File is empty.");
         return;
     }
+    if (!bex_region_ready) {
+        term_print("Not enough memory to run apps.");
+        return;
+    }
+    if (size + 4096 > BEX_REGION_SIZE - BEX_STACK_SIZE) {
+        term_print("File is too large to run.");
+        return;
+    }
 
-    uint8_t* load_addr = (uint8_t*)0x2000000;
+    uint8_t* load_addr = (uint8_t*)BEX_LOAD_ADDR;
     
     // Clear out any old program data that might be there
     for (uint32_t i = 0; i < size + 4096; i++) {
@@ -78,6 +100,6 @@ void load_bex(uint8_t drive, const char* filename) {
 
     term_print("Executing .bex file...");
     
-    uint32_t user_stack = 0x2800000;
+    uint32_t user_stack = BEX_LOAD_ADDR + BEX_REGION_SIZE;
     jmp_user((uint32_t)load_addr, user_stack);
 }
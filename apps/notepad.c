@@ -1,18 +1,44 @@
 #include "apps.h"
+#include "../mm/kmalloc.h"
 
-Window win_notepad = {400, 100, 400, 300, 0, 0, 0, 400, 100, 400, 300, "Notepad.txt"};
+Window win_notepad = {400, 100, 400, 300, 0, 0, 0, 400, 100, 400, 300, "Notepad.txt", {0}};
 
-char notepad_buf[1024] = {0};
+// Grows by doubling from the heap; no fixed limit on the text
+#define NOTEPAD_MIN_CAP 1024
+
+char* notepad_buf = 0;
 int notepad_len = 0;
+static int notepad_cap = 0;
+
+// Room for `len` characters; returns 0 when out of memory
+static int notepad_reserve(int len) {
+    if (len <= notepad_cap) return 1;
+    int cap = notepad_cap ? notepad_cap : NOTEPAD_MIN_CAP;
+    while (cap < len) cap *= 2;
+    char* p = (char*)krealloc(notepad_buf, cap);
+    if (!p) return 0;
+    notepad_buf = p;
+    notepad_cap = cap;
+    return 1;
+}
 
 void notepad_set_content(char* content, int len) {
-    if (len > 1024) len = 1024;
+    if (!notepad_reserve(len)) len = notepad_cap;
     for (int i = 0; i < len; i++) {
         notepad_buf[i] = content[i];
     }
     notepad_len = len;
 }
 
+void notepad_handle_key(char c) {
+    if (c == '\b') {
+        if (notepad_len > 0) notepad_len--;
+    } else if (notepad_reserve(notepad_len + 1)) {
+        notepad_buf[notepad_len++] = c;
+    }
+    window_invalidate(&win_notepad); // Update screen instantly as we type
+}
+
 void draw_notepad() {
     if (!win_notepad.open || win_notepad.minimized) return;
     draw_window_frame(&win_notepad);
@@ -1,4 +1,5 @@
 #include "apps.h"
+#include "../gfx/span.h"
 
 #define PAINT_CANVAS_W 320
 #define PAINT_CANVAS_H 200
@@ -11,7 +12,7 @@
 #define PAINT_TOOLBAR_TOP_OFFSET (PAINT_TITLEBAR_H + PAINT_TOP_PADDING)
 #define PAINT_CANVAS_TOP_OFFSET (PAINT_TOOLBAR_TOP_OFFSET + PAINT_TOOLBAR_H + PAINT_AFTER_TOOLBAR_GAP)
 
-Window win_paint = {180, 80, PAINT_CANVAS_W + (PAINT_LEFT_PADDING * 2), PAINT_CANVAS_H + PAINT_CANVAS_TOP_OFFSET + PAINT_BOTTOM_PADDING, 0, 0, 0, 180, 80, PAINT_CANVAS_W + (PAINT_LEFT_PADDING * 2), PAINT_CANVAS_H + PAINT_CANVAS_TOP_OFFSET + PAINT_BOTTOM_PADDING, "Paint"};
+Window win_paint = {180, 80, PAINT_CANVAS_W + (PAINT_LEFT_PADDING * 2), PAINT_CANVAS_H + PAINT_CANVAS_TOP_OFFSET + PAINT_BOTTOM_PADDING, 0, 0, 0, 180, 80, PAINT_CANVAS_W + (PAINT_LEFT_PADDING * 2), PAINT_CANVAS_H + PAINT_CANVAS_TOP_OFFSET + PAINT_BOTTOM_PADDING, "Paint", {0}};
 
 static uint32_t paint_canvas[PAINT_CANVAS_W * PAINT_CANVAS_H];
 static uint32_t paint_color = 0x000000;
@@ -46,45 +47,98 @@ int paint_handle_click(int mx, int my) {
         int sx = start_x + i * (PAINT_SWATCH_W + PAINT_SWATCH_GAP);
         if (mx >= sx && mx < sx + PAINT_SWATCH_W && my >= sy && my < sy + PAINT_SWATCH_W) {
             paint_color = colors[i];
-            force_render_frame = 1;
+            window_invalidate(&win_paint);
             return 1;
         }
     }
     if (mx >= PAINT_CLEAR_LEFT && mx < PAINT_CLEAR_LEFT + PAINT_CLEAR_W &&
         my >= PAINT_CLEAR_TOP && my < PAINT_CLEAR_TOP + PAINT_CLEAR_H) {
         paint_clear_canvas();
-        force_render_frame = 1;
+        window_invalidate(&win_paint);
         return 1;
     }
     return 0;
 }
 
+// --- Strokes ---
+// Samples arrive far apart when the mouse moves fast, so each one is
+// joined to the previous sample with a Bresenham line of brush stamps.
+static int stroke_active = 0;
+static int stroke_x, stroke_y;
+
+// Brush bounds touched since the last invalidate, in canvas coordinates
+static int dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+
+static void paint_stamp(int cx, int cy, int r) {
+    for (int dy = -r; dy <= r; dy++) {
+        int py = cy + dy;
+        if (py < 0 || py >= PAINT_CANVAS_H) continue;
+        for (int dx = -r; dx <= r; dx++) {
+            int px = cx + dx;
+            if (px < 0 || px >= PAINT_CANVAS_W) continue;
+            if (dx * dx + dy * dy <= r * r)
+                paint_canvas[py * PAINT_CANVAS_W + px] = paint_color;
+        }
+    }
+    if (cx - r < dirty_x0) dirty_x0 = cx - r;
+    if (cy - r < dirty_y0) dirty_y0 = cy - r;
+    if (cx + r + 1 > dirty_x1) dirty_x1 = cx + r + 1;
+    if (cy + r + 1 > dirty_y1) dirty_y1 = cy + r + 1;
+}
+
+static void paint_line(int x0, int y0, int x1, int y1, int r) {
+    int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+
+    while (1) {
+        paint_stamp(x0, y0, r);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
 void paint_handle_mouse(int mx, int my, int is_down) {
     if (!win_paint.open || win_paint.minimized) return;
 
+    if (!is_down) {
+        stroke_active = 0;
+        return;
+    }
+
     int canvas_left = win_paint.x + PAINT_LEFT_PADDING;
     int canvas_top = win_paint.y + PAINT_CANVAS_TOP_OFFSET;
     int cx = mx - canvas_left;
     int cy = my - canvas_top;
 
-    if (cx < 0 || cx >= PAINT_CANVAS_W || cy < 0 || cy >= PAINT_CANVAS_H)
+    // Strokes start on the canvas but may run off its edge
+    if (!stroke_active) {
+        if (cx < 0 || cx >= PAINT_CANVAS_W || cy < 0 || cy >= PAINT_CANVAS_H)
+            return;
+        stroke_active = 1;
+        stroke_x = cx;
+        stroke_y = cy;
+    } else if (cx == stroke_x && cy == stroke_y) {
         return;
-
-    if (!is_down) return;
+    }
 
     int r = paint_brush_size;
     if (r < 1) r = 1;
-    for (int dy = -r; dy <= r; dy++) {
-        for (int dx = -r; dx <= r; dx++) {
-            int px = cx + dx;
-            int py = cy + dy;
-            if (px < 0 || px >= PAINT_CANVAS_W || py < 0 || py >= PAINT_CANVAS_H)
-                continue;
-            if (dx * dx + dy * dy <= r * r)
-                paint_canvas[py * PAINT_CANVAS_W + px] = paint_color;
-        }
-    }
-    force_render_frame = 1;
+
+    dirty_x0 = dirty_y0 = 0x7FFFFFFF;
+    dirty_x1 = dirty_y1 = -0x7FFFFFFF;
+    paint_line(stroke_x, stroke_y, cx, cy, r);
+    stroke_x = cx;
+    stroke_y = cy;
+
+    // Only the stroke's bounds get repainted and presented; the window
+    // merges them until the next frame
+    window_invalidate_rect(&win_paint, canvas_left + dirty_x0, canvas_top + dirty_y0,
+                           dirty_x1 - dirty_x0, dirty_y1 - dirty_y0);
 }
 
 void draw_paint(void) {
@@ -129,9 +183,12 @@ void draw_paint(void) {
     int canvas_x = px + PAINT_LEFT_PADDING;
     int canvas_y = py + PAINT_CANVAS_TOP_OFFSET;
     draw_rect(canvas_x - 1, canvas_y - 1, PAINT_CANVAS_W + 2, PAINT_CANVAS_H + 2, 0x444444);
-    for (int y = 0; y < PAINT_CANVAS_H; y++) {
-        for (int x = 0; x < PAINT_CANVAS_W; x++) {
-            draw_pixel(canvas_x + x, canvas_y + y, paint_canvas[y * PAINT_CANVAS_W + x]);
-        }
+
+    // Copy the clipped part of the canvas a row at a time
+    int x = canvas_x, y = canvas_y, w = PAINT_CANVAS_W, h = PAINT_CANVAS_H;
+    if (!backbuffer || !gfx_clip_rect(&x, &y, &w, &h)) return;
+    for (int row = y; row < y + h; row++) {
+        const uint32_t* src = paint_canvas + (row - canvas_y) * PAINT_CANVAS_W + (x - canvas_x);
+        gfx_copy_span(gfx_row(row) + x, src, w);
     }
 }
@@ -1,6 +1,7 @@
 #include "apps.h"
+#include "../drivers/smp.h"
 
-Window win_settings = {300, 150, 400, 370, 0, 0, 0, 300, 150, 400, 370, "Settings"};
+Window win_settings = {300, 150, 400, 370, 0, 0, 0, 300, 150, 400, 370, "Settings", {0}};
 
 int current_theme = 0; // 0 = Dark, 1 = Light
 int settings_page = 0; // 0 = Personalization, 1 = About
@@ -115,7 +116,14 @@ void draw_settings() {
         ram_msg[ri++] = ' '; ram_msg[ri++] = 'M'; ram_msg[ri++] = 'B'; ram_msg[ri++] = '\0';
         draw_string(ram_msg, content_x, set_y + 110, txt_col);
 
-        draw_string("Processor:", content_x, set_y + 130, txt_col);
+        char cpu_msg[32] = "Processor: ";
+        char cpu_val[16];
+        itoa(cpu_count, cpu_val);
+        int ci = 11; for(int j=0; cpu_val[j]; j++) cpu_msg[ci++] = cpu_val[j];
+        const char* cores = (cpu_count == 1) ? " core" : " cores";
+        for(int j=0; cores[j]; j++) cpu_msg[ci++] = cores[j];
+        cpu_msg[ci] = '\0';
+        draw_string(cpu_msg, content_x, set_y + 130, txt_col);
         draw_string(cpu_brand, content_x, set_y + 145, 0xAAAAAA);
         
         char res_msg[32] = "Resolution: ";
@@ -4,10 +4,16 @@
 #include "../drivers/fat32.h"
 #include "../drivers/ahci.h"
 #include "../drivers/net.h"
+#include "../drivers/timer.h"
+#include "../drivers/smp.h"
+#include "../gfx/bench.h"
+#include "../gfx/frame.h"
+#include "../mm/kmalloc.h"
+#include "../mm/paging.h"
 #include <stddef.h>
 
 // --- Terminal Window ---
-Window win_terminal = {100, 100, 620, 380, 0, 0, 0, 100, 100, 620, 380, "Terminal"};
+Window win_terminal = {100, 100, 620, 380, 0, 0, 0, 100, 100, 620, 380, "Terminal", {0}};
 
 // --- Mount Table ---
 #define MAX_MOUNTS 8
@@ -23,9 +29,15 @@ static int mount_count = 0;
 // --- Terminal State ---
 #define TERM_COLS 78
 #define TERM_ROWS 20
-#define TERM_MAX_LINES 200
-
-static char lines[TERM_MAX_LINES][TERM_COLS + 1];
+// Scrollback grows from TERM_LINES_MIN up to TERM_LINES_MAX, then the
+// oldest line is dropped for each new one
+#define TERM_LINES_MIN 64
+#define TERM_LINES_MAX 1024
+
+// A ring of heap strings, oldest at line_first
+static char** lines = NULL;
+static int line_cap = 0;
+static int line_first = 0;
 static int line_count = 0;
 static char input_buf[128];
 static int input_len = 0;
@@ -59,23 +71,49 @@ static void int_to_str(int v, char* buf) {
 }
 
 // --- Output Functions ---
+static const char* term_line(int i) {
+    return lines[(line_first + i) % line_cap];
+}
+
+// Double the ring, unwrapping it so the oldest line lands at index 0
+static int term_grow() {
+    int cap = line_cap ? line_cap * 2 : TERM_LINES_MIN;
+    if (cap > TERM_LINES_MAX) cap = TERM_LINES_MAX;
+    char** grown = (char**)kmalloc(cap * sizeof(char*));
+    if (!grown) return 0;
+    for (int i = 0; i < line_count; i++) grown[i] = lines[(line_first + i) % line_cap];
+    kfree(lines);
+    lines = grown;
+    line_cap = cap;
+    line_first = 0;
+    return 1;
+}
+
 void term_print(const char* s) {
-    if (line_count >= TERM_MAX_LINES) {
-        // Scroll: shift lines up by one
-        for (int i = 0; i < TERM_MAX_LINES - 1; i++)
-            str_copy(lines[i], lines[i+1]);
-        line_count = TERM_MAX_LINES - 1;
+    if (line_count == line_cap && (line_cap >= TERM_LINES_MAX || !term_grow())) {
+        if (!line_cap) return;
+        // Full: the oldest line makes room
+        kfree(lines[line_first]);
+        line_first = (line_first + 1) % line_cap;
+        line_count--;
     }
     int l = str_len(s);
     if (l > TERM_COLS) l = TERM_COLS;
-    for (int i = 0; i < l; i++) lines[line_count][i] = s[i];
-    lines[line_count][l] = 0;
+    char* line = (char*)kmalloc(l + 1);
+    if (!line) return;
+    for (int i = 0; i < l; i++) line[i] = s[i];
+    line[l] = 0;
+    lines[(line_first + line_count) % line_cap] = line;
     line_count++;
+    // Output can come from a running .bex, with no key press to repaint
+    window_invalidate(&win_terminal);
 }
 
 static void term_clear() {
+    for (int i = 0; i < line_count; i++) kfree(lines[(line_first + i) % line_cap]);
     line_count = 0;
-    for (int i = 0; i < TERM_MAX_LINES; i++) lines[i][0] = 0;
+    line_first = 0;
+    window_invalidate(&win_terminal);
 }
 
 // --- Format a FAT file entry name into a human-readable 8.3 string ---
@@ -422,7 +460,8 @@ static void cmd_ping(const char* arg) {
 
     // Poll for reply with timeout
     int got_reply = 0;
-    for (int i = 0; i < 2000000; i++) {
+    uint64_t deadline = timer_deadline(2000);
+    while (now_ns() < deadline) {
         e1000_poll();
         if (net_state.ping_replied) {
             got_reply = 1;
@@ -442,8 +481,12 @@ static void cmd_ping(const char* arg) {
             for (int j = 0; j < nl; j++) reply[p++] = num[j];
             if (i < 3) reply[p++] = '.';
         }
-        const char* ok = " - Success";
+        const char* ok = " - Success, time=";
         while (*ok) reply[p++] = *ok++;
+        char ms[12];
+        int_to_str((int)net_state.ping_rtt_ms, ms);
+        for (int j = 0; ms[j]; j++) reply[p++] = ms[j];
+        reply[p++] = 'm'; reply[p++] = 's';
         reply[p] = 0;
         term_print(reply);
     } else {
@@ -590,6 +633,18 @@ static void execute_command(char* cmd_str) {
         cmd_netinfo();
     } else if (str_case_cmp(tok1, "ping") == 0) {
         cmd_ping(tok2);
+    } else if (str_case_cmp(tok1, "gfxbench") == 0) {
+        gfx_bench_fill(term_print);
+        gfx_bench_blend(term_print);
+        gfx_bench_text(term_print);
+        gfx_bench_present(term_print);
+        frame_report(term_print);
+    } else if (str_case_cmp(tok1, "meminfo") == 0) {
+        kmalloc_report(term_print);
+    } else if (str_case_cmp(tok1, "vmmap") == 0) {
+        paging_report(term_print);
+    } else if (str_case_cmp(tok1, "cpus") == 0) {
+        smp_report(term_print);
     } else if (str_len(tok1) > 4 && str_case_cmp(tok1 + str_len(tok1) - 4, ".bex") == 0) {
         // Find drive and filename similar to cmd_cat
         uint8_t drive = 255;
@@ -642,12 +697,12 @@ void terminal_handle_key(char c) {
         force_render_frame = 1;
     } else if (c == '\b') {
         if (input_len > 0) input_len--;
-        force_render_frame = 1;
+        window_invalidate(&win_terminal);
     } else {
         if (input_len < 127) {
             input_buf[input_len++] = c;
             input_buf[input_len] = 0;
-            force_render_frame = 1;
+            window_invalidate(&win_terminal);
         }
     }
 }
@@ -670,7 +725,7 @@ void draw_terminal() {
     if (start < 0) start = 0;
 
     for (int i = start; i < line_count; i++) {
-        draw_string(lines[i], cx, cy, 0xAAFFAA);
+        draw_string(term_line(i), cx, cy, 0xAAFFAA);
         cy += line_h;
     }
 
@@ -13,4 +13,8 @@ extern void sys_window_create(int w, int h, const char* title, uint32_t* buffer)
 extern void sys_window_update();
 extern void sys_get_event(int* mouse_x, int* mouse_y, int* mouse_clicked);
 
+// Show a changed part of the canvas on the next frame. Once an app calls
+// this, sys_window_update stops redrawing the whole canvas every time.
+extern void sys_window_present(int x, int y, int w, int h);
+
 #endif
\ No newline at end of file
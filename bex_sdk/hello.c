@@ -25,26 +25,30 @@ int main() {
 
     int mx, my, clicked;
     int running = 1;
+    int last_hover = -1;
 
-    while (running) {
-        // Redraw Background
-        fill_rect(0, 0, WIDTH, HEIGHT, bg_color);
+    // Draw the background once
+    fill_rect(0, 0, WIDTH, HEIGHT, bg_color);
+    sys_window_present(0, 0, WIDTH, HEIGHT);
 
+    while (running) {
         // Fetch events
         sys_get_event(&mx, &my, &clicked);
 
         // Check if mouse is over button
         int hover = (mx >= btn_x && mx <= btn_x + btn_w && my >= btn_y && my <= btn_y + btn_h);
 
-        if (hover) {
-            fill_rect(btn_x, btn_y, btn_w, btn_h, 0xFF0000); // Hover color
-            if (clicked) {
-                char msg[] = "You clicked the GUI Button!";
-                sys_popup(msg);
-                running = 0; // Exit after clicking
-            }
-        } else {
-            fill_rect(btn_x, btn_y, btn_w, btn_h, btn_color);
+        // Only the button ever changes, and only when the hover state does
+        if (hover != last_hover) {
+            fill_rect(btn_x, btn_y, btn_w, btn_h, hover ? 0xFF0000 : btn_color);
+            sys_window_present(btn_x, btn_y, btn_w, btn_h);
+            last_hover = hover;
+        }
+
+        if (hover && clicked) {
+            char msg[] = "You clicked the GUI Button!";
+            sys_popup(msg);
+            running = 0; // Exit after clicking
         }
 
         // Pass control back to OS to render screen
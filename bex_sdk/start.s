@@ -84,6 +84,25 @@ sys_get_event:
     pop ebp
     ret
 
+global sys_window_present
+sys_window_present:
+    push ebp
+    mov ebp, esp
+    push ebx
+    push esi
+
+    mov eax, 7         ; sys_window_present
+    mov ebx, [ebp+8]   ; x
+    mov ecx, [ebp+12]  ; y
+    mov edx, [ebp+16]  ; w
+    mov esi, [ebp+20]  ; h
+    int 0x80
+
+    pop esi
+    pop ebx
+    pop ebp
+    ret
+
 global sys_exit
 sys_exit:
     mov eax, 2         ; sys_exit syscall number
@@ -93,6 +93,66 @@ as_isr128:
     popad
     iret
 
+; --- Hardware IRQs ---
+; Each line pushes its number and shares one body that saves the
+; interrupted state and hands the number to irq_handler.
+extern irq_handler
+
+%macro IRQ_STUB 1
+as_irq%1:
+    push dword %1
+    jmp irq_common
+%endmacro
+
+IRQ_STUB 0
+IRQ_STUB 1
+IRQ_STUB 2
+IRQ_STUB 3
+IRQ_STUB 4
+IRQ_STUB 5
+IRQ_STUB 6
+IRQ_STUB 7
+IRQ_STUB 8
+IRQ_STUB 9
+IRQ_STUB 10
+IRQ_STUB 11
+IRQ_STUB 12
+IRQ_STUB 13
+IRQ_STUB 14
+IRQ_STUB 15
+
+irq_common:
+    pushad
+    push ds
+    push es
+    push fs
+    push gs
+    
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    cld
+    
+    push dword [esp+48] ; IRQ number, above the segments and pushad
+    call irq_handler
+    add esp, 4
+    
+    pop gs
+    pop fs
+    pop es
+    pop ds
+    popad
+    add esp, 4
+    iret
+
+section .data
+global irq_stubs
+irq_stubs:
+    dd as_irq0, as_irq1, as_irq2, as_irq3, as_irq4, as_irq5, as_irq6, as_irq7
+    dd as_irq8, as_irq9, as_irq10, as_irq11, as_irq12, as_irq13, as_irq14, as_irq15
+
+section .text
+
 global jmp_user
 global return_to_kernel
 
@@ -124,3 +184,76 @@ jmp_user:
 
 return_to_kernel:
     jmp jmp_user.exit
+
+; --- Inter-Processor Interrupts ---
+; APs sleep in hlt between jobs; the wake IPI only has to be acknowledged.
+; smp.c points lapic_eoi_reg at the local APIC it found.
+global as_ipi_wake
+global as_ipi_spurious
+global lapic_eoi_reg
+
+as_ipi_wake:
+    push eax
+    mov eax, [lapic_eoi_reg]
+    mov dword [eax], 0
+    pop eax
+    iret
+
+; Spurious APIC interrupts take no EOI
+as_ipi_spurious:
+    iret
+
+section .data
+lapic_eoi_reg dd 0xFEE000B0
+
+; --- AP Startup ---
+; smp.c copies this to AP_TRAMPOLINE, below 1 MiB, and points the SIPI at
+; it. It fills in the kernel GDT pointer, a stack and the C entry point at
+; the end, so the code itself references no kernel symbols.
+AP_TRAMPOLINE equ 0x8000
+%define TRAMP(label) (AP_TRAMPOLINE + (label) - ap_trampoline)
+
+section .text
+global ap_trampoline
+global ap_trampoline_end
+global ap_gdt_ptr
+global ap_stack
+global ap_entry
+
+bits 16
+ap_trampoline:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+    o32 lgdt [TRAMP(ap_gdt_ptr)]
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+    jmp dword 0x08:TRAMP(ap_protected)
+
+bits 32
+ap_protected:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+    mov esp, [TRAMP(ap_stack)]
+    call dword [TRAMP(ap_entry)]
+.hang:
+    cli
+    hlt
+    jmp .hang
+
+align 4
+ap_gdt_ptr:
+    dw 0
+    dd 0
+align 4
+ap_stack:
+    dd 0
+ap_entry:
+    dd 0
+ap_trampoline_end:
@@ -1,14 +1,14 @@
 #include "ahci.h"
 #include "pci.h"
+#include "../mm/pmm.h"
 #include <stddef.h>
 
 static HBA_MEM* abar = NULL;
 static int ahci_ports[32]; // 0: none, 1: SATA
+static uint32_t ahci_port_mem[32]; // kept across repeated ahci_init calls
 
-// Static memory for AHCI structures to avoid complex allocation
-// Each port needs ~4KB for command list + FIS + command table(s)
-// Using 8KB per port at 0x200000 (2MB) - safe for systems with 4MB+ RAM
-#define AHCI_BASE_MEM   0x200000
+// Each port needs ~4KB for command list + FIS + command table(s);
+// every active port gets 8KB of its own from the page allocator
 #define AHCI_PORT_SIZE  8192 
 
 void ahci_init() {
@@ -61,6 +61,13 @@ found:
                 else
                     continue;
 
+                if (!ahci_port_mem[i]) ahci_port_mem[i] = pmm_alloc(AHCI_PORT_SIZE);
+                uint32_t port_base = ahci_port_mem[i];
+                if (!port_base) {
+                    ahci_ports[i] = AHCI_DEV_NULL;
+                    continue;
+                }
+
                 // Basic initialization for the port (SATA and SATAPI)
                 abar->ports[i].cmd &= ~((1 << 0) | (1 << 4)); // ST=0, FRE=0
                 int timeout = 1000000;
@@ -68,10 +75,9 @@ found:
                     asm volatile("pause");
                 }
 
-                uint8_t* pmem = (uint8_t*)(AHCI_BASE_MEM + (i * AHCI_PORT_SIZE));
+                uint8_t* pmem = (uint8_t*)port_base;
                 for (int m = 0; m < AHCI_PORT_SIZE; m++) pmem[m] = 0;
 
-                uint32_t port_base = AHCI_BASE_MEM + (i * AHCI_PORT_SIZE);
                 abar->ports[i].clb = port_base;           // Command list at offset 0
                 abar->ports[i].clbu = 0;
                 abar->ports[i].fb = port_base + 1024;     // FIS at offset 1024
@@ -277,3 +283,7 @@ int ahci_satapi_read_sector(int port, uint32_t lba, uint8_t* buffer) {
     if (timeout <= 0) return 0;
     return 1;
 }
+
+uint32_t ahci_mmio_base(void) {
+    return (uint32_t)abar;
+}
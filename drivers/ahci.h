@@ -130,4 +130,7 @@ int ahci_drive_exists(int port);
 int ahci_get_satapi_port(void);
 int ahci_satapi_read_sector(int port, uint32_t lba, uint8_t* buffer);
 
+// Register block of the controller ahci_init found, 0 without one
+uint32_t ahci_mmio_base(void);
+
 #endif
@@ -0,0 +1,94 @@
+#include "bga.h"
+#include "pci.h"
+
+static inline void outw(uint16_t port, uint16_t val) {
+    asm volatile ("outw %0, %1" : : "a"(val), "Nd"(port));
+}
+
+static inline uint16_t inw(uint16_t port) {
+    uint16_t ret;
+    asm volatile ("inw %1, %0" : "=a"(ret) : "Nd"(port));
+    return ret;
+}
+
+// --- VBE DISPI Interface ---
+#define VBE_DISPI_IOPORT_INDEX 0x01CE
+#define VBE_DISPI_IOPORT_DATA  0x01CF
+
+#define VBE_DISPI_INDEX_ID          0x0
+#define VBE_DISPI_INDEX_XRES        0x1
+#define VBE_DISPI_INDEX_YRES        0x2
+#define VBE_DISPI_INDEX_BPP         0x3
+#define VBE_DISPI_INDEX_ENABLE      0x4
+#define VBE_DISPI_INDEX_VIRT_WIDTH  0x6
+#define VBE_DISPI_INDEX_VIRT_HEIGHT 0x7
+#define VBE_DISPI_INDEX_X_OFFSET    0x8
+#define VBE_DISPI_INDEX_Y_OFFSET    0x9
+
+#define VBE_DISPI_ID0     0xB0C0
+#define VBE_DISPI_ENABLED 0x01
+
+int bga_page_count = 0;
+
+static uint32_t page_base;
+static uint32_t page_bytes;
+static uint16_t page_lines;
+
+static uint16_t dispi_read(uint16_t index) {
+    outw(VBE_DISPI_IOPORT_INDEX, index);
+    return inw(VBE_DISPI_IOPORT_DATA);
+}
+
+static void dispi_write(uint16_t index, uint16_t val) {
+    outw(VBE_DISPI_IOPORT_INDEX, index);
+    outw(VBE_DISPI_IOPORT_DATA, val);
+}
+
+static int bga_pci_find(void) {
+    for (uint16_t bus = 0; bus < 256; bus++) {
+        for (uint8_t slot = 0; slot < 32; slot++) {
+            uint32_t reg0 = pci_config_read(bus, slot, 0, 0);
+            if ((reg0 & 0xFFFF) == BGA_VENDOR && (reg0 >> 16) == BGA_DEVICE) return 1;
+        }
+    }
+    return 0;
+}
+
+int bga_init(uint32_t fb_addr, uint32_t pitch, uint32_t height) {
+    bga_page_count = 0;
+    if (!bga_pci_find()) return 0;
+
+    uint16_t id = dispi_read(VBE_DISPI_INDEX_ID);
+    if ((id & 0xFFF0) != VBE_DISPI_ID0) return 0;
+
+    // Only take over a linear mode the bootloader set through DISPI, and
+    // only if the framebuffer starts at the top of it
+    if (!(dispi_read(VBE_DISPI_INDEX_ENABLE) & VBE_DISPI_ENABLED)) return 0;
+    if (dispi_read(VBE_DISPI_INDEX_YRES) != height) return 0;
+    if (dispi_read(VBE_DISPI_INDEX_Y_OFFSET) != 0 || dispi_read(VBE_DISPI_INDEX_X_OFFSET) != 0) return 0;
+
+    // Rewriting the virtual width makes the adapter recompute how many
+    // lines of VRAM are addressable
+    uint16_t xres = dispi_read(VBE_DISPI_INDEX_XRES);
+    uint16_t bpp = dispi_read(VBE_DISPI_INDEX_BPP);
+    if (bpp == 0 || (uint32_t)xres * ((bpp + 7) / 8) != pitch) return 0;
+    dispi_write(VBE_DISPI_INDEX_VIRT_WIDTH, xres);
+
+    int pages = dispi_read(VBE_DISPI_INDEX_VIRT_HEIGHT) / height;
+    if (pages > BGA_MAX_PAGES) pages = BGA_MAX_PAGES;
+    if (pages < 2) return 0;
+
+    page_base = fb_addr;
+    page_bytes = pitch * height;
+    page_lines = height;
+    bga_page_count = pages;
+    return pages;
+}
+
+uint32_t* bga_page(int page) {
+    return (uint32_t*)(page_base + page * page_bytes);
+}
+
+void bga_show_page(int page) {
+    dispi_write(VBE_DISPI_INDEX_Y_OFFSET, page * page_lines);
+}
@@ -0,0 +1,25 @@
+#ifndef BGA_H
+#define BGA_H
+
+#include <stdint.h>
+
+// Bochs Graphics Adapter (QEMU -vga std, Bochs, VirtualBox VBoxVGA)
+#define BGA_VENDOR 0x1234
+#define BGA_DEVICE 0x1111
+
+#define BGA_MAX_PAGES 3
+
+// Number of VRAM pages available for flipping, 0 when flipping is off
+extern int bga_page_count;
+
+// Look for the adapter and carve its VRAM into full-screen pages stacked
+// vertically from fb_addr. Needs at least two pages to enable flipping.
+// Returns bga_page_count.
+int bga_init(uint32_t fb_addr, uint32_t pitch, uint32_t height);
+
+uint32_t* bga_page(int page);
+
+// Scan out the given page from the next frame on.
+void bga_show_page(int page);
+
+#endif
@@ -0,0 +1,61 @@
+#include "cpu.h"
+
+int cpu_cpuid_supported = 0;
+uint32_t cpu_feature_edx = 0;
+uint32_t cpu_feature_ecx = 0;
+int cpu_simd_enabled = 0;
+
+// CPUID exists if the ID bit (21) in EFLAGS can be toggled.
+// Early 486s cannot, and executing CPUID there is #UD.
+static int cpuid_probe(void) {
+    uint32_t before, after;
+    asm volatile(
+        "pushfl\n"
+        "popl %0\n"
+        "movl %0, %1\n"
+        "xorl $0x200000, %1\n"
+        "pushl %1\n"
+        "popfl\n"
+        "pushfl\n"
+        "popl %1\n"
+        "pushl %0\n"
+        "popfl\n"
+        : "=&r"(before), "=&r"(after));
+    return ((before ^ after) & 0x200000) != 0;
+}
+
+void cpu_detect(void) {
+    cpu_cpuid_supported = cpuid_probe();
+    if (!cpu_cpuid_supported) return;
+
+    uint32_t max_leaf, ebx, ecx, edx;
+    asm volatile("cpuid" : "=a"(max_leaf), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0));
+    if (max_leaf < 1) return;
+
+    uint32_t eax;
+    asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1));
+    cpu_feature_edx = edx;
+    cpu_feature_ecx = ecx;
+}
+
+void cpu_enable_simd(void) {
+    if (!cpu_has(CPU_FEAT_FPU)) return;
+
+    uint32_t cr0;
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    cr0 &= ~((1 << 2) | (1 << 3)); // EM=0, TS=0
+    cr0 |= (1 << 1) | (1 << 5);    // MP=1, NE=1
+    asm volatile("mov %0, %%cr0" : : "r"(cr0));
+    asm volatile("fninit");
+
+    if (cpu_has(CPU_FEAT_MMX)) cpu_simd_enabled |= CPU_SIMD_MMX;
+
+    if (cpu_has(CPU_FEAT_SSE) && cpu_has(CPU_FEAT_FXSR)) {
+        uint32_t cr4;
+        asm volatile("mov %%cr4, %0" : "=r"(cr4));
+        cr4 |= (1 << 9) | (1 << 10); // OSFXSR, OSXMMEXCPT
+        asm volatile("mov %0, %%cr4" : : "r"(cr4));
+        cpu_simd_enabled |= CPU_SIMD_SSE;
+        if (cpu_has(CPU_FEAT_SSE2)) cpu_simd_enabled |= CPU_SIMD_SSE2;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+// CPUID leaf 1 EDX feature bits
+#define CPU_FEAT_FPU   (1 << 0)
+#define CPU_FEAT_PSE   (1 << 3)
+#define CPU_FEAT_TSC   (1 << 4)
+#define CPU_FEAT_MSR   (1 << 5)
+#define CPU_FEAT_APIC  (1 << 9)
+#define CPU_FEAT_MTRR  (1 << 12)
+#define CPU_FEAT_PGE   (1 << 13)
+#define CPU_FEAT_CMOV  (1 << 15)
+#define CPU_FEAT_PAT   (1 << 16)
+#define CPU_FEAT_MMX   (1 << 23)
+#define CPU_FEAT_FXSR  (1 << 24)
+#define CPU_FEAT_SSE   (1 << 25)
+#define CPU_FEAT_SSE2  (1 << 26)
+
+// SIMD state enabled by cpu_enable_simd()
+#define CPU_SIMD_MMX   (1 << 0)
+#define CPU_SIMD_SSE   (1 << 1)
+#define CPU_SIMD_SSE2  (1 << 2)
+
+extern int cpu_cpuid_supported;
+extern uint32_t cpu_feature_edx;
+extern uint32_t cpu_feature_ecx;
+extern int cpu_simd_enabled;
+
+void cpu_detect(void);
+
+// Turns on the x87/MMX unit and, when present, SSE state (CR4.OSFXSR).
+// The kernel is still built with -mno-sse; only code that checks
+// cpu_simd_enabled may use these registers.
+void cpu_enable_simd(void);
+
+static inline int cpu_has(uint32_t edx_bit) {
+    return (cpu_feature_edx & edx_bit) != 0;
+}
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    asm volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t val) {
+    asm volatile("wrmsr" : : "c"(msr), "a"((uint32_t)val), "d"((uint32_t)(val >> 32)));
+}
+
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include "input.h"
+#include "pic.h"
+#include "timer.h"
+
+static inline void outb(uint16_t port, uint8_t val) {
+    asm volatile ( "outb %0, %1" : : "a"(val), "Nd"(port) );
+}
+
+static inline uint8_t inb(uint16_t port) {
+    uint8_t ret;
+    asm volatile ( "inb %1, %0" : "=a"(ret) : "Nd"(port) );
+    return ret;
+}
+
+#define PS2_DATA   0x60
+#define PS2_STATUS 0x64
+
+#define PS2_STATUS_OUTPUT (1 << 0)
+#define PS2_STATUS_INPUT  (1 << 1)
+#define PS2_STATUS_AUX    (1 << 5)
+
+// --- Event Ring ---
+// Single producer, single consumer. The producers are the two IRQ
+// handlers, which never nest because both run with interrupts off; the
+// consumer is the desktop loop. Each side only writes its own index, and
+// the counters run freely so head - tail is the fill level.
+#define RING_MASK (INPUT_RING_SIZE - 1)
+
+static InputEvent ring[INPUT_RING_SIZE];
+static volatile uint32_t ring_head;
+static volatile uint32_t ring_tail;
+
+volatile uint32_t input_dropped = 0;
+
+static void ring_push(const InputEvent* ev) {
+    uint32_t head = ring_head;
+    if (head - ring_tail == INPUT_RING_SIZE) {
+        input_dropped++;
+        return;
+    }
+    ring[head & RING_MASK] = *ev;
+    // Publish the slot before the index that makes it visible
+    asm volatile("" ::: "memory");
+    ring_head = head + 1;
+}
+
+int input_pop(InputEvent* ev) {
+    uint32_t tail = ring_tail;
+    if (tail == ring_head) return 0;
+    asm volatile("" ::: "memory");
+    *ev = ring[tail & RING_MASK];
+    asm volatile("" ::: "memory");
+    ring_tail = tail + 1;
+    return 1;
+}
+
+int input_pending(void) {
+    return ring_tail != ring_head;
+}
+
+// --- Decoding ---
+static uint8_t key_extended;
+static uint8_t mouse_cycle;
+static uint8_t mouse_packet[3];
+
+static void key_byte(uint8_t data) {
+    if (data == 0xE0) {
+        key_extended = 1;
+        return;
+    }
+
+    InputEvent ev = {0};
+    ev.type = INPUT_KEY;
+    ev.code = data & 0x7F;
+    ev.flags = ((data & 0x80) ? INPUT_KEY_RELEASE : 0) |
+               (key_extended ? INPUT_KEY_EXTENDED : 0);
+    ev.time = ticks();
+    key_extended = 0;
+    ring_push(&ev);
+}
+
+static void mouse_byte(uint8_t data) {
+    // Bit 3 of the first byte is always set; use it to find packet starts
+    if (mouse_cycle == 0 && !(data & 0x08)) return;
+
+    mouse_packet[mouse_cycle++] = data;
+    if (mouse_cycle < 3) return;
+    mouse_cycle = 0;
+
+    uint8_t b0 = mouse_packet[0];
+    if (b0 & 0xC0) return; // Overflowed; the deltas are meaningless
+
+    // Nine-bit two's complement, sign bits in the first byte
+    InputEvent ev = {0};
+    ev.type = INPUT_MOUSE;
+    ev.flags = b0 & 0x07;
+    ev.dx = (int16_t)(mouse_packet[1] - ((b0 << 4) & 0x100));
+    ev.dy = (int16_t)(mouse_packet[2] - ((b0 << 3) & 0x100));
+    ev.time = ticks();
+    ring_push(&ev);
+}
+
+// Either IRQ drains every pending byte; the AUX status bit says whose it is
+static void ps2_irq(void) {
+    uint8_t status;
+    while ((status = inb(PS2_STATUS)) & PS2_STATUS_OUTPUT) {
+        uint8_t data = inb(PS2_DATA);
+        if (status & PS2_STATUS_AUX) mouse_byte(data);
+        else key_byte(data);
+    }
+}
+
+static void ps2_wait_write(void) {
+    uint32_t timeout = 100000;
+    while ((inb(PS2_STATUS) & PS2_STATUS_INPUT) && --timeout);
+}
+
+static void ps2_wait_read(void) {
+    uint32_t timeout = 100000;
+    while (!(inb(PS2_STATUS) & PS2_STATUS_OUTPUT) && --timeout);
+}
+
+void input_init(void) {
+    int was_enabled = interrupts_enabled();
+    asm volatile("cli");
+
+    // Controller configuration byte: bit 0 keyboard IRQ, bit 1 mouse IRQ
+    ps2_wait_write();
+    outb(PS2_STATUS, 0x20);
+    ps2_wait_read();
+    uint8_t config = inb(PS2_DATA) | 0x03;
+    ps2_wait_write();
+    outb(PS2_STATUS, 0x60);
+    ps2_wait_write();
+    outb(PS2_DATA, config);
+
+    irq_install_handler(1, ps2_irq);
+    irq_install_handler(12, ps2_irq);
+
+    // A byte already waiting raised its edge before we listened
+    ps2_irq();
+
+    if (was_enabled) asm volatile("sti");
+}
@@ -0,0 +1,47 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+
+// --- PS/2 Input Events ---
+// IRQ1 and IRQ12 decode controller bytes into events as they arrive; the
+// desktop loop drains them whenever it gets round to it, so a slow frame
+// delays input handling but never loses it.
+
+#define INPUT_KEY   1
+#define INPUT_MOUSE 2
+
+// INPUT_KEY flags
+#define INPUT_KEY_RELEASE  (1 << 0)
+#define INPUT_KEY_EXTENDED (1 << 1)   // Came after an 0xE0 prefix
+
+// INPUT_MOUSE buttons
+#define INPUT_BTN_LEFT   (1 << 0)
+#define INPUT_BTN_RIGHT  (1 << 1)
+#define INPUT_BTN_MIDDLE (1 << 2)
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  code;       // Key: set 1 scancode without the release bit
+    uint8_t  flags;      // Key: INPUT_KEY_*, mouse: INPUT_BTN_*
+    uint8_t  pad;
+    int16_t  dx, dy;     // Mouse: movement, y positive upwards
+    uint32_t time;       // ticks() when the last byte arrived
+} InputEvent;
+
+// Power of two; a full ring drops new events
+#define INPUT_RING_SIZE 256
+
+// Events lost to a full ring since boot
+extern volatile uint32_t input_dropped;
+
+// Enable both controller interrupts and route IRQ1/IRQ12 here. Call after
+// mouse_install, which still talks to the mouse by polling.
+void input_init(void);
+
+// Take the oldest event; returns 0 when the ring is empty
+int input_pop(InputEvent* ev);
+
+int input_pending(void);
+
+#endif
@@ -0,0 +1,193 @@
+#include "mtrr.h"
+#include "cpu.h"
+
+#define MSR_MTRRCAP          0xFE
+#define MSR_MTRR_DEF_TYPE    0x2FF
+#define MSR_MTRR_PHYSBASE(n) (0x200 + 2 * (n))
+#define MSR_MTRR_PHYSMASK(n) (0x201 + 2 * (n))
+
+#define MTRRCAP_WC        (1 << 10)
+#define MTRR_DEF_ENABLE   (1 << 11)
+#define MTRR_MASK_VALID   (1 << 11)
+
+#define MTRR_MAX_VAR 16
+
+typedef struct {
+    uint64_t base;
+    uint64_t size;
+    uint8_t type;
+} MtrrRange;
+
+int mtrr_fb_status = MTRR_UNSUPPORTED;
+
+static uint64_t phys_mask;
+
+static int phys_addr_bits(void) {
+    uint32_t max_ext, ebx, ecx, edx;
+    asm volatile("cpuid" : "=a"(max_ext), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000000));
+    if (max_ext < 0x80000008) return 36;
+
+    uint32_t eax;
+    asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000008));
+    return eax & 0xFF;
+}
+
+// Split [start, end) into naturally aligned power-of-two blocks, the only
+// shape a variable MTRR can describe. Returns 0 if out exceeds max.
+static int add_blocks(MtrrRange* out, int* count, int max, uint64_t start, uint64_t end, uint8_t type) {
+    while (start < end) {
+        uint64_t size = 0x1000;
+        while (!(start & (size * 2 - 1)) && start + size * 2 <= end) size *= 2;
+        if (*count >= max) return 0;
+        out[*count].base = start;
+        out[*count].size = size;
+        out[*count].type = type;
+        (*count)++;
+        start += size;
+    }
+    return 1;
+}
+
+// Raw copy of the boot CPU's variable ranges for the APs
+static int saved_vcnt;
+static uint64_t saved_def;
+static uint64_t saved_base[MTRR_MAX_VAR];
+static uint64_t saved_mask[MTRR_MAX_VAR];
+
+// SDM 11.11.7.2: caches off and flushed, MTRRs disabled while they change
+static void update_begin(uint32_t* flags, uint32_t* cr0) {
+    asm volatile("pushfl; popl %0; cli" : "=r"(*flags));
+    asm volatile("mov %%cr0, %0" : "=r"(*cr0));
+    asm volatile("mov %0, %%cr0" : : "r"((*cr0 | (1 << 30)) & ~(1u << 29)));
+    asm volatile("wbinvd" ::: "memory");
+    wrmsr(MSR_MTRR_DEF_TYPE, rdmsr(MSR_MTRR_DEF_TYPE) & ~(uint64_t)MTRR_DEF_ENABLE);
+}
+
+static void update_end(uint32_t flags, uint32_t cr0, uint64_t def) {
+    asm volatile("wbinvd" ::: "memory");
+    wrmsr(MSR_MTRR_DEF_TYPE, def);
+    asm volatile("mov %0, %%cr0" : : "r"(cr0));
+    asm volatile("pushl %0; popfl" : : "r"(flags) : "cc");
+}
+
+static void mtrr_write_all(const MtrrRange* ranges, int count, int vcnt) {
+    uint32_t flags, cr0;
+    uint64_t def = rdmsr(MSR_MTRR_DEF_TYPE);
+    update_begin(&flags, &cr0);
+
+    for (int i = 0; i < vcnt; i++) {
+        if (i < count) {
+            uint64_t mask = ~(ranges[i].size - 1) & phys_mask;
+            wrmsr(MSR_MTRR_PHYSBASE(i), ranges[i].base | ranges[i].type);
+            wrmsr(MSR_MTRR_PHYSMASK(i), mask | MTRR_MASK_VALID);
+        } else {
+            wrmsr(MSR_MTRR_PHYSMASK(i), 0);
+            wrmsr(MSR_MTRR_PHYSBASE(i), 0);
+        }
+    }
+
+    update_end(flags, cr0, def);
+}
+
+int mtrr_set_wc(uint32_t base, uint32_t size) {
+    int status = MTRR_UNSUPPORTED;
+    if (!cpu_has(CPU_FEAT_MTRR) || !cpu_has(CPU_FEAT_MSR) || size == 0) goto out;
+
+    uint64_t cap = rdmsr(MSR_MTRRCAP);
+    int vcnt = cap & 0xFF;
+    if (vcnt > MTRR_MAX_VAR) vcnt = MTRR_MAX_VAR;
+    if (!(cap & MTRRCAP_WC)) { status = MTRR_NO_WC; goto out; }
+    if (!(rdmsr(MSR_MTRR_DEF_TYPE) & MTRR_DEF_ENABLE)) { status = MTRR_DISABLED; goto out; }
+
+    phys_mask = ((1ULL << phys_addr_bits()) - 1) & ~0xFFFULL;
+
+    uint64_t fb0 = base & ~0xFFFu;
+    uint64_t fb1 = ((uint64_t)base + size + 0xFFF) & ~0xFFFULL;
+
+    MtrrRange ranges[MTRR_MAX_VAR];
+    int count = 0;
+    int wc_cover = 0;
+    int overlaps = 0;
+
+    for (int i = 0; i < vcnt; i++) {
+        uint64_t mask = rdmsr(MSR_MTRR_PHYSMASK(i));
+        if (!(mask & MTRR_MASK_VALID)) continue;
+
+        uint64_t b = rdmsr(MSR_MTRR_PHYSBASE(i));
+        MtrrRange r;
+        r.base = b & phys_mask;
+        r.type = b & 0xFF;
+        r.size = ((~mask) & phys_mask) + 0x1000;
+
+        int contiguous = (r.size & (r.size - 1)) == 0;
+        int overlap = r.base < fb1 && fb0 < r.base + r.size;
+        if (overlap && !contiguous) { status = MTRR_CONFLICT; goto out; }
+
+        if (overlap) {
+            uint64_t end = r.base + r.size;
+            overlaps++;
+            if (r.type == MTRR_TYPE_WC && r.base <= fb0 && end >= fb1) wc_cover = 1;
+            // Keep everything of this range except the framebuffer itself
+            if (!add_blocks(ranges, &count, MTRR_MAX_VAR, r.base, fb0 < end ? fb0 : end, r.type) ||
+                !add_blocks(ranges, &count, MTRR_MAX_VAR, fb1 > r.base ? fb1 : r.base, end, r.type)) {
+                status = MTRR_NO_FREE;
+                goto out;
+            }
+        } else {
+            if (count >= MTRR_MAX_VAR) { status = MTRR_NO_FREE; goto out; }
+            ranges[count++] = r;
+        }
+    }
+
+    if (wc_cover && overlaps == 1) { status = MTRR_ALREADY; goto out; }
+
+    if (!add_blocks(ranges, &count, MTRR_MAX_VAR, fb0, fb1, MTRR_TYPE_WC) || count > vcnt) {
+        status = MTRR_NO_FREE;
+        goto out;
+    }
+
+    mtrr_write_all(ranges, count, vcnt);
+    status = MTRR_OK;
+
+out:
+    mtrr_fb_status = status;
+    return status;
+}
+
+void mtrr_save(void) {
+    saved_vcnt = 0;
+    if (!cpu_has(CPU_FEAT_MTRR) || !cpu_has(CPU_FEAT_MSR)) return;
+
+    saved_vcnt = rdmsr(MSR_MTRRCAP) & 0xFF;
+    if (saved_vcnt > MTRR_MAX_VAR) saved_vcnt = MTRR_MAX_VAR;
+    saved_def = rdmsr(MSR_MTRR_DEF_TYPE);
+    for (int i = 0; i < saved_vcnt; i++) {
+        saved_base[i] = rdmsr(MSR_MTRR_PHYSBASE(i));
+        saved_mask[i] = rdmsr(MSR_MTRR_PHYSMASK(i));
+    }
+}
+
+void mtrr_load(void) {
+    if (!saved_vcnt) return;
+
+    uint32_t flags, cr0;
+    update_begin(&flags, &cr0);
+    for (int i = 0; i < saved_vcnt; i++) {
+        wrmsr(MSR_MTRR_PHYSMASK(i), 0);
+        wrmsr(MSR_MTRR_PHYSBASE(i), saved_base[i]);
+        wrmsr(MSR_MTRR_PHYSMASK(i), saved_mask[i]);
+    }
+    update_end(flags, cr0, saved_def);
+}
+
+const char* mtrr_status_str(int status) {
+    switch (status) {
+        case MTRR_OK:          return "write-combining (MTRR)";
+        case MTRR_ALREADY:     return "write-combining (firmware)";
+        case MTRR_NO_WC:       return "uncached, CPU lacks WC";
+        case MTRR_DISABLED:    return "uncached, MTRRs disabled";
+        case MTRR_NO_FREE:     return "unchanged, no free MTRRs";
+        case MTRR_CONFLICT:    return "unchanged, overlapping MTRR";
+        default:               return "unchanged, no MTRR support";
+    }
+}
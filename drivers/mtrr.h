@@ -0,0 +1,36 @@
+#ifndef MTRR_H
+#define MTRR_H
+
+#include <stdint.h>
+
+// Memory types
+#define MTRR_TYPE_UC 0
+#define MTRR_TYPE_WC 1
+#define MTRR_TYPE_WB 6
+
+// mtrr_set_wc() results
+#define MTRR_OK           0
+#define MTRR_ALREADY      1
+#define MTRR_UNSUPPORTED -1
+#define MTRR_NO_WC       -2
+#define MTRR_DISABLED    -3
+#define MTRR_NO_FREE     -4
+#define MTRR_CONFLICT    -5
+
+// Result of the last mtrr_set_wc(), for the benchmark report
+extern int mtrr_fb_status;
+
+// Make [base, base + size) write-combining using variable-range MTRRs.
+// Ranges the firmware already set over it (usually UC for the PCI hole)
+// are split around it, since UC would otherwise win. Nothing is changed
+// unless the whole layout fits in the available registers.
+int mtrr_set_wc(uint32_t base, uint32_t size);
+
+// Snapshot the variable ranges and default type on the boot CPU, then
+// replay them on each AP, which only has what the firmware set up
+void mtrr_save(void);
+void mtrr_load(void);
+
+const char* mtrr_status_str(int status);
+
+#endif
@@ -1,5 +1,7 @@
 #include "net.h"
 #include "pci.h"
+#include "timer.h"
+#include "../mm/kmalloc.h"
 #include <stdint.h>
 #include <stddef.h>
 
@@ -172,10 +174,10 @@ static void e1000_read_mac(void) {
     for (int i = 0; i < 3; i++) {
         e1000_write(E1000_EERD, (1) | ((uint32_t)i << 8));
         uint32_t val;
-        int timeout = 10000;
+        uint64_t deadline = timer_deadline(10);
         do {
             val = e1000_read(E1000_EERD);
-        } while (!(val & (1 << 4)) && --timeout > 0);
+        } while (!(val & (1 << 4)) && now_ns() < deadline);
 
         uint16_t data = (val >> 16) & 0xFFFF;
         net_state.mac[i * 2]     = data & 0xFF;
@@ -255,8 +257,8 @@ void e1000_init(void) {
 
     // Reset the device
     e1000_write(E1000_CTRL, E1000_CTRL_RST);
-    // Small delay for reset
-    for (volatile int i = 0; i < 100000; i++);
+    // The reset bit self-clears within 1 ms
+    sleep_until(timer_deadline(10));
 
     // Disable interrupts (we use polling)
     e1000_write(E1000_IMC, 0xFFFFFFFF);
@@ -270,7 +272,7 @@ void e1000_init(void) {
     e1000_write(E1000_CTRL, ctrl);
 
     // Small delay for link to come up
-    for (volatile int i = 0; i < 100000; i++);
+    sleep_until(timer_deadline(10));
 
     // Read MAC address
     e1000_read_mac();
@@ -296,9 +298,10 @@ int e1000_send(const void* data, uint16_t len) {
     uint16_t cur = net_state.tx_cur;
 
     // Wait for descriptor to be available
-    int timeout = 100000;
-    while (!(tx_descs[cur].status & E1000_TXD_STAT_DD) && --timeout > 0);
-    if (timeout <= 0) return -1;
+    uint64_t deadline = timer_deadline(10);
+    while (!(tx_descs[cur].status & E1000_TXD_STAT_DD)) {
+        if (now_ns() >= deadline) return -1;
+    }
 
     // Copy packet data into TX buffer
     net_memcpy(&tx_buffers[cur][0], data, len);
@@ -438,6 +441,7 @@ static void net_handle_icmp(const uint8_t* pkt, uint16_t len) {
         // ICMP Echo Reply — this is the response to our ping
         if (net_state.ping_active && ntohs(icmp->seq) == net_state.ping_seq) {
             net_state.ping_replied = 1;
+            net_state.ping_rtt_ms = ticks() - net_state.ping_sent_tick;
         }
     }
 }
@@ -559,6 +563,23 @@ static uint16_t tcp_checksum(const uint8_t* src_ip, const uint8_t* dst_ip,
 // (Removed old TCP send functions, moved below net_get_mac_for_ip)
 
 
+// ===== Grow the HTTP receive buffer =====
+// Doubles up to HTTP_BUF_MAX; returns 0 if `len` bytes don't fit
+static int http_buf_reserve(int len) {
+    if (len <= net_state.http_buf_cap) return 1;
+    if (len > HTTP_BUF_MAX) return 0;
+
+    int cap = net_state.http_buf_cap ? net_state.http_buf_cap : HTTP_BUF_SIZE;
+    while (cap < len) cap *= 2;
+    if (cap > HTTP_BUF_MAX) cap = HTTP_BUF_MAX;
+
+    uint8_t* buf = (uint8_t*)krealloc(net_state.http_buf, cap);
+    if (!buf) return 0;
+    net_state.http_buf = buf;
+    net_state.http_buf_cap = cap;
+    return 1;
+}
+
 // ===== Handle incoming TCP =====
 static void net_handle_tcp(const uint8_t* pkt, uint16_t len) {
     struct ip_header* ip = (struct ip_header*)(pkt + sizeof(struct eth_header));
@@ -603,10 +624,11 @@ static void net_handle_tcp(const uint8_t* pkt, uint16_t len) {
 
             // Only accept in-order data
             if (seq == net_state.tcp_remote_seq) {
-                // Copy to HTTP buffer
-                if (net_state.http_buf && net_state.http_buf_len + tcp_data_len < HTTP_BUF_SIZE) {
+                // Copy to HTTP buffer, keeping it NUL-terminated
+                if (net_state.http_buf && http_buf_reserve(net_state.http_buf_len + tcp_data_len + 1)) {
                     net_memcpy(net_state.http_buf + net_state.http_buf_len, data, tcp_data_len);
                     net_state.http_buf_len += tcp_data_len;
+                    net_state.http_buf[net_state.http_buf_len] = 0;
                 }
                 net_state.tcp_remote_seq += tcp_data_len;
             }
@@ -724,7 +746,8 @@ void net_send_ping(uint8_t ip0, uint8_t ip1, uint8_t ip2, uint8_t ip3) {
         net_send_arp_request(net_state.gateway_ip);
 
         // Poll for ARP reply (with timeout)
-        for (int i = 0; i < 500000 && !net_state.gateway_mac_valid; i++) {
+        uint64_t deadline = timer_deadline(1000);
+        while (!net_state.gateway_mac_valid && now_ns() < deadline) {
             e1000_poll();
         }
 
@@ -781,6 +804,7 @@ void net_send_ping(uint8_t ip0, uint8_t ip1, uint8_t ip2, uint8_t ip3) {
 
     icmp->checksum = ip_checksum(icmp, sizeof(struct icmp_header) + icmp_data_len);
 
+    net_state.ping_sent_tick = ticks();
     e1000_send(tx_packet_buf, total_len);
 }
 
@@ -789,7 +813,8 @@ static int net_ensure_gateway_mac(void) {
     if (net_state.gateway_mac_valid) return 1;
 
     net_send_arp_request(net_state.gateway_ip);
-    for (int i = 0; i < 500000 && !net_state.gateway_mac_valid; i++) {
+    uint64_t deadline = timer_deadline(1000);
+    while (!net_state.gateway_mac_valid && now_ns() < deadline) {
         e1000_poll();
     }
     return net_state.gateway_mac_valid;
@@ -993,7 +1018,8 @@ int net_dns_resolve(const char* hostname, uint8_t* out_ip) {
     }
 
     // Poll for response with timeout
-    for (int i = 0; i < 40000000 && !net_state.dns_resolved; i++) {
+    uint64_t deadline = timer_deadline(3000);
+    while (!net_state.dns_resolved && now_ns() < deadline) {
         e1000_poll();
     }
 
@@ -1012,9 +1038,6 @@ int net_dns_resolve(const char* hostname, uint8_t* out_ip) {
 
 // (Removed redundant net_strlen)
 
-// ===== Static HTTP receive buffer =====
-static uint8_t http_recv_buf[HTTP_BUF_SIZE];
-
 // ===== Ephemeral port counter =====
 static uint16_t next_ephemeral_port = 49152;
 
@@ -1050,16 +1073,17 @@ int net_http_get(const char* host, const char* path, uint8_t* out_buf, int max_l
         net_state.tcp_local_seq = (uint32_t)net_state.tcp_local_port * 1000 + 1;
         net_state.tcp_remote_seq = 0;
 
-        net_state.http_buf = http_recv_buf;
+        if (!http_buf_reserve(HTTP_BUF_SIZE)) return -1;
         net_state.http_buf_len = 0;
         net_state.http_done = 0;
-        net_memset(http_recv_buf, 0, HTTP_BUF_SIZE);
+        net_state.http_buf[0] = 0;
 
         net_state.tcp_state = TCP_STATE_SYN_SENT;
         net_send_tcp(TCP_SYN, NULL, 0);
         net_state.tcp_local_seq++;
 
-        for (int i = 0; i < 3000000 && net_state.tcp_state == TCP_STATE_SYN_SENT; i++) {
+        uint64_t deadline = timer_deadline(3000);
+        while (net_state.tcp_state == TCP_STATE_SYN_SENT && now_ns() < deadline) {
             e1000_poll();
         }
         if (net_state.tcp_state != TCP_STATE_ESTABLISHED) {
@@ -1080,12 +1104,13 @@ int net_http_get(const char* host, const char* path, uint8_t* out_buf, int max_l
         net_send_tcp(TCP_ACK | TCP_PSH, request, (uint16_t)rp);
         net_state.tcp_local_seq += rp;
 
-        for (int i = 0; i < 10000000 && !net_state.http_done; i++) {
+        deadline = timer_deadline(10000);
+        while (!net_state.http_done && now_ns() < deadline) {
             e1000_poll();
         }
 
         // --- Check for Redirect ---
-        char* resp = (char*)http_recv_buf;
+        char* resp = (char*)net_state.http_buf;
         // Verify we got "HTTP/1.x 30"
         if (net_state.http_buf_len > 12 && net_strncasecmp(resp, "HTTP/", 5) == 0) {
             char* status = net_strstr(resp, " ");
@@ -1150,14 +1175,15 @@ int net_http_get(const char* host, const char* path, uint8_t* out_buf, int max_l
 
     int copy_len = net_state.http_buf_len;
     if (copy_len > max_len - 1) copy_len = max_len - 1;
-    net_memcpy(out_buf, http_recv_buf, copy_len);
+    net_memcpy(out_buf, net_state.http_buf, copy_len);
     out_buf[copy_len] = 0;
 
     if (net_state.tcp_state != TCP_STATE_CLOSED) {
         net_send_tcp(TCP_ACK | TCP_FIN, NULL, 0);
         net_state.tcp_local_seq++;
         net_state.tcp_state = TCP_STATE_FIN_WAIT;
-        for (int i = 0; i < 500000 && net_state.tcp_state != TCP_STATE_CLOSED; i++) {
+        uint64_t deadline = timer_deadline(1000);
+        while (net_state.tcp_state != TCP_STATE_CLOSED && now_ns() < deadline) {
             e1000_poll();
         }
         net_state.tcp_state = TCP_STATE_CLOSED;
@@ -27,6 +27,8 @@
 #define E1000_RAH      0x5404   // Receive Address High
 #define E1000_MTA      0x5200   // Multicast Table Array (128 entries)
 
+#define E1000_MMIO_SIZE 0x20000 // BAR0 register window
+
 // CTRL bits
 #define E1000_CTRL_SLU    (1 << 6)   // Set Link Up
 #define E1000_CTRL_RST    (1 << 26)  // Device Reset
@@ -156,8 +158,10 @@ struct tcp_header {
 #define TCP_STATE_ESTABLISHED 2
 #define TCP_STATE_FIN_WAIT    3
 
-// HTTP receive buffer size
+// HTTP receive buffer: starts at HTTP_BUF_SIZE on the heap and doubles
+// as a response arrives, up to HTTP_BUF_MAX
 #define HTTP_BUF_SIZE 8192
+#define HTTP_BUF_MAX  (256 * 1024)
 
 // ===== Network State =====
 typedef struct {
@@ -178,7 +182,8 @@ typedef struct {
     int       ping_active;
     int       ping_replied;
     uint16_t  ping_seq;
-    uint32_t  ping_sent_tick;
+    uint32_t  ping_sent_tick;  // ticks() when the request went out
+    uint32_t  ping_rtt_ms;
     // DNS state
     uint8_t  dns_server[4];    // DNS server IP (default: 1.1.1.1)
     uint8_t  dns_result[4];    // Resolved IP address
@@ -194,8 +199,9 @@ typedef struct {
     uint8_t  tcp_remote_ip[4];
     uint8_t  tcp_remote_mac[6];
     // HTTP receive state
-    uint8_t* http_buf;          // Points to static buffer
+    uint8_t* http_buf;          // Heap buffer, kept between requests
     int      http_buf_len;      // Bytes received so far
+    int      http_buf_cap;
     int      http_done;         // 1 when transfer complete
     uint16_t ip_id;             // Sequential IP ID
 } NetState;
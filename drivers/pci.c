@@ -38,3 +38,45 @@ void pci_config_write(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, u
     outl(0xCF8, address);
     outl(0xCFC, val);
 }
+
+int pci_find_mem_bar(uint32_t addr, uint32_t* base, uint32_t* size) {
+    for (uint16_t bus = 0; bus < 256; bus++) {
+        for (uint8_t slot = 0; slot < 32; slot++) {
+            uint32_t vend_dev = pci_config_read(bus, slot, 0, 0);
+            if (vend_dev == 0xFFFFFFFF) continue;
+
+            // Only plain devices have six BARs
+            uint32_t header = pci_config_read(bus, slot, 0, 0x0C);
+            if (((header >> 16) & 0x7F) != 0) continue;
+
+            for (uint8_t off = 0x10; off <= 0x24; off += 4) {
+                uint32_t bar = pci_config_read(bus, slot, 0, off);
+                if (bar & 1) continue; // I/O space
+
+                int is64 = ((bar >> 1) & 3) == 2;
+                uint32_t bar_base = bar & 0xFFFFFFF0;
+                if (bar_base == 0 || addr < bar_base) {
+                    if (is64) off += 4;
+                    continue;
+                }
+
+                // Size it with memory decode off so nothing answers at ~0
+                uint32_t cmd = pci_config_read(bus, slot, 0, 0x04);
+                pci_config_write(bus, slot, 0, 0x04, cmd & ~(uint32_t)(1 << 1));
+                pci_config_write(bus, slot, 0, off, 0xFFFFFFFF);
+                uint32_t probe = pci_config_read(bus, slot, 0, off);
+                pci_config_write(bus, slot, 0, off, bar);
+                pci_config_write(bus, slot, 0, 0x04, cmd);
+
+                uint32_t bar_size = ~(probe & 0xFFFFFFF0) + 1;
+                if (bar_size && addr - bar_base < bar_size) {
+                    *base = bar_base;
+                    *size = bar_size;
+                    return 1;
+                }
+                if (is64) off += 4;
+            }
+        }
+    }
+    return 0;
+}
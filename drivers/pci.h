@@ -6,4 +6,8 @@
 uint32_t pci_config_read(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset);
 void pci_config_write(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint32_t val);
 
+// Find the 32-bit memory BAR that contains addr and return its base and
+// decoded size. Leaves base/size untouched and returns 0 if none does.
+int pci_find_mem_bar(uint32_t addr, uint32_t* base, uint32_t* size);
+
 #endif
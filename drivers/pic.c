@@ -0,0 +1,73 @@
+#include "pic.h"
+
+static inline void outb(uint16_t port, uint8_t val) {
+    asm volatile ( "outb %0, %1" : : "a"(val), "Nd"(port) );
+}
+
+static inline uint8_t inb(uint16_t port) {
+    uint8_t ret;
+    asm volatile ( "inb %1, %0" : "=a"(ret) : "Nd"(port) );
+    return ret;
+}
+
+// --- 8259 Ports ---
+#define PIC1_CMD  0x20
+#define PIC1_DATA 0x21
+#define PIC2_CMD  0xA0
+#define PIC2_DATA 0xA1
+
+#define PIC_EOI       0x20
+#define PIC_READ_ISR  0x0B
+
+static irq_handler_t irq_handlers[IRQ_COUNT];
+
+// Port 0x80 is unused; writing it gives old PICs time between init words
+static inline void io_wait(void) {
+    outb(0x80, 0);
+}
+
+void pic_init(void) {
+    outb(PIC1_CMD, 0x11);  io_wait();   // ICW1: edge triggered, cascade, ICW4 follows
+    outb(PIC2_CMD, 0x11);  io_wait();
+    outb(PIC1_DATA, IRQ_BASE);     io_wait();   // ICW2: vector offsets
+    outb(PIC2_DATA, IRQ_BASE + 8); io_wait();
+    outb(PIC1_DATA, 0x04); io_wait();   // ICW3: slave on IRQ2
+    outb(PIC2_DATA, 0x02); io_wait();
+    outb(PIC1_DATA, 0x01); io_wait();   // ICW4: 8086 mode
+    outb(PIC2_DATA, 0x01); io_wait();
+
+    // Everything masked except the cascade; lines open as drivers claim them
+    outb(PIC1_DATA, 0xFB);
+    outb(PIC2_DATA, 0xFF);
+}
+
+void irq_install_handler(int irq, irq_handler_t handler) {
+    if (irq < 0 || irq >= IRQ_COUNT) return;
+    irq_handlers[irq] = handler;
+
+    if (irq < 8) {
+        outb(PIC1_DATA, inb(PIC1_DATA) & ~(1 << irq));
+    } else {
+        outb(PIC2_DATA, inb(PIC2_DATA) & ~(1 << (irq - 8)));
+    }
+}
+
+static uint8_t pic_in_service(uint16_t cmd_port) {
+    outb(cmd_port, PIC_READ_ISR);
+    return inb(cmd_port);
+}
+
+void irq_handler(uint32_t irq) {
+    // A line that drops before the CPU acknowledges it shows up as IRQ 7
+    // or 15 with nothing in service; those get no EOI from that chip
+    if (irq == 7 && !(pic_in_service(PIC1_CMD) & 0x80)) return;
+    if (irq == 15 && !(pic_in_service(PIC2_CMD) & 0x80)) {
+        outb(PIC1_CMD, PIC_EOI);
+        return;
+    }
+
+    if (irq < IRQ_COUNT && irq_handlers[irq]) irq_handlers[irq]();
+
+    if (irq >= 8) outb(PIC2_CMD, PIC_EOI);
+    outb(PIC1_CMD, PIC_EOI);
+}
@@ -0,0 +1,31 @@
+#ifndef PIC_H
+#define PIC_H
+
+#include <stdint.h>
+
+// IRQ 0-15 land on vectors 32-47, clear of the CPU exceptions
+#define IRQ_BASE 32
+#define IRQ_COUNT 16
+
+typedef void (*irq_handler_t)(void);
+
+// Entry stubs in boot.s, one per IRQ line, for idt_install
+extern uint32_t irq_stubs[IRQ_COUNT];
+
+// Remap both 8259s to IRQ_BASE and mask every line
+void pic_init(void);
+
+// Route an IRQ line to a handler and unmask it. The handler runs with
+// interrupts off; the EOI is sent after it returns.
+void irq_install_handler(int irq, irq_handler_t handler);
+
+// Called from the boot.s stubs
+void irq_handler(uint32_t irq);
+
+static inline int interrupts_enabled(void) {
+    uint32_t flags;
+    asm volatile("pushfl; popl %0" : "=r"(flags));
+    return (flags >> 9) & 1;
+}
+
+#endif
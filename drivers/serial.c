@@ -0,0 +1,58 @@
+#include "serial.h"
+
+static inline void outb(uint16_t port, uint8_t val) {
+    asm volatile ( "outb %0, %1" : : "a"(val), "Nd"(port) );
+}
+
+static inline uint8_t inb(uint16_t port) {
+    uint8_t ret;
+    asm volatile ( "inb %1, %0" : "=a"(ret) : "Nd"(port) );
+    return ret;
+}
+
+// --- 16550 UART Registers ---
+#define UART_DATA   0   // DLAB=0
+#define UART_IER    1   // DLAB=0
+#define UART_DLL    0   // DLAB=1
+#define UART_DLM    1   // DLAB=1
+#define UART_FCR    2
+#define UART_LCR    3
+#define UART_MCR    4
+#define UART_LSR    5
+
+#define LSR_THR_EMPTY 0x20
+
+int serial_ready = 0;
+
+void serial_init(void) {
+    outb(COM1_PORT + UART_IER, 0x00);   // No interrupts
+    outb(COM1_PORT + UART_LCR, 0x80);   // DLAB on
+    outb(COM1_PORT + UART_DLL, 0x01);   // 115200 / 1
+    outb(COM1_PORT + UART_DLM, 0x00);
+    outb(COM1_PORT + UART_LCR, 0x03);   // 8N1, DLAB off
+    outb(COM1_PORT + UART_FCR, 0xC7);   // FIFOs on and cleared, 14-byte threshold
+
+    // Loopback self-test; a missing port reads back 0xFF
+    outb(COM1_PORT + UART_MCR, 0x1E);
+    outb(COM1_PORT + UART_DATA, 0xAE);
+    if (inb(COM1_PORT + UART_DATA) != 0xAE) return;
+
+    outb(COM1_PORT + UART_MCR, 0x0F);   // Normal mode, DTR/RTS/OUT1/OUT2
+    serial_ready = 1;
+}
+
+static void serial_putc(char c) {
+    // Bounded so a wedged UART can't hang the caller
+    for (int spins = 0; spins < 100000; spins++) {
+        if (inb(COM1_PORT + UART_LSR) & LSR_THR_EMPTY) break;
+    }
+    outb(COM1_PORT + UART_DATA, (uint8_t)c);
+}
+
+void serial_write(const char* str) {
+    if (!serial_ready) return;
+    for (; *str; str++) {
+        if (*str == '\n') serial_putc('\r');
+        serial_putc(*str);
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stdint.h>
+
+#define COM1_PORT 0x3F8
+
+// Set after serial_init found a UART that echoes in loopback mode
+extern int serial_ready;
+
+// 115200 baud, 8N1, FIFOs on, no interrupts
+void serial_init(void);
+
+// Blocking write; "\n" goes out as "\r\n". Does nothing without a UART.
+void serial_write(const char* str);
+
+#endif
@@ -0,0 +1,401 @@
+#include "smp.h"
+#include "cpu.h"
+#include "mtrr.h"
+#include "timer.h"
+#include "../mm/pmm.h"
+#include "../mm/paging.h"
+
+// Real-mode start code in boot.s. The three data labels at its end are
+// filled in here before each AP is started.
+extern uint8_t ap_trampoline[];
+extern uint8_t ap_trampoline_end[];
+extern uint8_t ap_gdt_ptr[];
+extern uint8_t ap_stack[];
+extern uint8_t ap_entry[];
+extern volatile uint32_t lapic_eoi_reg;
+
+// Page the SIPI vector points at; boot.s assembles for this address
+#define AP_TRAMPOLINE 0x8000
+
+// Local APIC registers
+#define LAPIC_ID        0x020
+#define LAPIC_EOI       0x0B0
+#define LAPIC_SVR       0x0F0
+#define LAPIC_ICR_LO    0x300
+#define LAPIC_ICR_HI    0x310
+#define LAPIC_LVT_LINT0 0x350
+#define LAPIC_LVT_LINT1 0x360
+
+#define SVR_ENABLE       (1 << 8)
+#define ICR_FIXED        0x00000000
+#define ICR_INIT         0x00000500
+#define ICR_STARTUP      0x00000600
+#define ICR_PENDING      0x00001000
+#define ICR_ASSERT       0x00004000
+#define ICR_LEVEL        0x00008000
+#define ICR_ALL_BUT_SELF 0x000C0000
+#define LVT_NMI          0x00000400
+#define LVT_EXTINT       0x00000700
+
+#define MSR_APIC_BASE    0x1B
+#define APIC_BASE_ENABLE (1 << 11)
+
+// MADT entry types
+#define MADT_LAPIC          0
+#define MADT_LAPIC_OVERRIDE 5
+
+typedef struct {
+    char sig[8];
+    uint8_t checksum;
+    char oem[6];
+    uint8_t revision;
+    uint32_t rsdt;
+} __attribute__((packed)) AcpiRsdp;
+
+typedef struct {
+    char sig[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem[6];
+    char oem_table[8];
+    uint32_t oem_revision;
+    uint32_t creator;
+    uint32_t creator_revision;
+} __attribute__((packed)) AcpiHeader;
+
+typedef struct {
+    AcpiHeader h;
+    uint32_t lapic;
+    uint32_t flags;
+    uint8_t entries[];
+} __attribute__((packed)) AcpiMadt;
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) DescPtr;
+
+typedef struct {
+    smp_job_fn fn;
+    void* arg;
+    SmpGroup* group;
+} Job;
+
+CpuData cpus[SMP_MAX_CPUS];
+int cpu_count = 1;
+int smp_cpus_listed = 1;
+
+static uint32_t lapic_base;
+static DescPtr boot_gdtr, boot_idtr;
+static CpuData* volatile ap_starting;
+static uint8_t trampoline_saved[PAGE_SIZE];
+
+static Job queue[SMP_QUEUE_SIZE];
+static uint32_t queue_head, queue_tail;   // free running, under queue_lock
+static volatile uint32_t queue_lock;
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return *(volatile uint32_t*)(lapic_base + reg);
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t val) {
+    *(volatile uint32_t*)(lapic_base + reg) = val;
+}
+
+static inline void cpu_relax(void) {
+    asm volatile("pause" ::: "memory");
+}
+
+static void send_ipi(uint8_t apic_id, uint32_t icr) {
+    lapic_write(LAPIC_ICR_HI, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_ICR_LO, icr);
+    while (lapic_read(LAPIC_ICR_LO) & ICR_PENDING) cpu_relax();
+}
+
+static void spin_until(uint64_t deadline_ns) {
+    while (now_ns() < deadline_ns) cpu_relax();
+}
+
+// --- MADT ---
+
+static int checksum_ok(const void* p, uint32_t len) {
+    const uint8_t* b = (const uint8_t*)p;
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < len; i++) sum += b[i];
+    return sum == 0;
+}
+
+static int sig_is(const char* sig, const char* want, int len) {
+    for (int i = 0; i < len; i++) {
+        if (sig[i] != want[i]) return 0;
+    }
+    return 1;
+}
+
+static AcpiRsdp* scan_rsdp(uint32_t start, uint32_t end) {
+    for (uint32_t p = start; p + sizeof(AcpiRsdp) <= end; p += 16) {
+        AcpiRsdp* r = (AcpiRsdp*)p;
+        if (sig_is(r->sig, "RSD PTR ", 8) && checksum_ok(r, sizeof(AcpiRsdp))) return r;
+    }
+    return 0;
+}
+
+static AcpiMadt* find_madt(void) {
+    // First KiB of the EBDA, then the BIOS area. The EBDA segment is in
+    // the BIOS data area; read it in asm, GCC flags page-0 pointers.
+    uint32_t ebda;
+    asm volatile("movzwl 0x40E, %0" : "=r"(ebda));
+    ebda <<= 4;
+    AcpiRsdp* rsdp = 0;
+    if (ebda >= 0x80000 && ebda < 0xA0000) rsdp = scan_rsdp(ebda, ebda + 1024);
+    if (!rsdp) rsdp = scan_rsdp(0xE0000, 0x100000);
+    if (!rsdp || !rsdp->rsdt) return 0;
+
+    AcpiHeader* rsdt = (AcpiHeader*)rsdp->rsdt;
+    if (!sig_is(rsdt->sig, "RSDT", 4) || !checksum_ok(rsdt, rsdt->length)) return 0;
+
+    uint32_t* tables = (uint32_t*)(rsdt + 1);
+    uint32_t count = (rsdt->length - sizeof(AcpiHeader)) / 4;
+    for (uint32_t i = 0; i < count; i++) {
+        AcpiHeader* t = (AcpiHeader*)tables[i];
+        if (t && sig_is(t->sig, "APIC", 4) && checksum_ok(t, t->length)) return (AcpiMadt*)t;
+    }
+    return 0;
+}
+
+// --- AP Startup ---
+
+static void run_job(CpuData* c, Job* j) {
+    j->fn(j->arg);
+    c->jobs++;
+    __sync_fetch_and_sub(&j->group->pending, 1);
+}
+
+static void queue_acquire(void) {
+    while (__sync_lock_test_and_set(&queue_lock, 1)) {
+        while (queue_lock) cpu_relax();
+    }
+}
+
+static void queue_release(void) {
+    __sync_lock_release(&queue_lock);
+}
+
+static int take_job(Job* out) {
+    int found = 0;
+    queue_acquire();
+    if (queue_head != queue_tail) {
+        *out = queue[queue_tail % SMP_QUEUE_SIZE];
+        queue_tail++;
+        found = 1;
+    }
+    queue_release();
+    return found;
+}
+
+// Runs on the AP's own stack with the kernel GDT loaded and paging off
+static void ap_main(void) {
+    CpuData* c = ap_starting;
+
+    asm volatile("lidt %0" : : "m"(boot_idtr));
+    mtrr_load();
+    paging_enable();
+    cpu_enable_simd();
+    lapic_write(LAPIC_SVR, SVR_ENABLE | LAPIC_SPURIOUS);
+    c->online = 1;
+
+    // The wake IPI ends the hlt; its handler only does the EOI
+    for (;;) {
+        Job j;
+        asm volatile("cli");
+        if (take_job(&j)) {
+            run_job(c, &j);
+            continue;
+        }
+        asm volatile("sti; hlt");
+    }
+}
+
+static int start_ap(CpuData* c) {
+    ap_starting = c;
+    *(uint32_t*)(AP_TRAMPOLINE + (ap_stack - ap_trampoline)) = c->stack + SMP_STACK_SIZE;
+
+    send_ipi(c->apic_id, ICR_INIT | ICR_ASSERT | ICR_LEVEL);
+    send_ipi(c->apic_id, ICR_INIT | ICR_LEVEL);
+    spin_until(timer_deadline(10));
+
+    // A second SIPI is ignored by a core that already started
+    for (int i = 0; i < 2 && !c->online; i++) {
+        send_ipi(c->apic_id, ICR_STARTUP | (AP_TRAMPOLINE >> 12));
+        spin_until(now_ns() + 200000);
+    }
+
+    uint64_t deadline = timer_deadline(100);
+    while (!c->online && now_ns() < deadline) cpu_relax();
+    if (c->online) return 1;
+
+    // Park it again so it cannot wake up in the restored page later
+    send_ipi(c->apic_id, ICR_INIT | ICR_ASSERT | ICR_LEVEL);
+    return 0;
+}
+
+void smp_init(void) {
+    cpus[0].index = 0;
+    cpus[0].online = 1;
+    cpu_count = 1;
+    smp_cpus_listed = 1;
+
+    if (!cpu_has(CPU_FEAT_APIC) || !cpu_has(CPU_FEAT_MSR)) return;
+    AcpiMadt* madt = find_madt();
+    if (!madt) return;
+
+    uint8_t ids[SMP_MAX_CPUS];
+    int listed = 0;
+    uint64_t lapic = madt->lapic;
+    uint8_t* p = madt->entries;
+    uint8_t* end = (uint8_t*)madt + madt->h.length;
+    while (p + 2 <= end && p[1] >= 2 && p + p[1] <= end) {
+        if (p[0] == MADT_LAPIC && p[1] >= 8 && (*(uint32_t*)(p + 4) & 1)) {
+            if (listed < SMP_MAX_CPUS) ids[listed] = p[3];
+            listed++;
+        } else if (p[0] == MADT_LAPIC_OVERRIDE && p[1] >= 12) {
+            lapic = *(uint64_t*)(p + 4);
+        }
+        p += p[1];
+    }
+    if (!listed || !lapic || (lapic >> 32)) return;
+    smp_cpus_listed = listed;
+
+    // The boot CPU's APIC has to be on to send IPIs. LINT0 stays the
+    // virtual-wire input the 8259 interrupts arrive on.
+    lapic_base = (uint32_t)lapic;
+    paging_map(lapic_base, PAGE_SIZE, MEM_UC, "Local APIC");
+    lapic_eoi_reg = lapic_base + LAPIC_EOI;
+    uint64_t msr = rdmsr(MSR_APIC_BASE);
+    if (!(msr & APIC_BASE_ENABLE)) wrmsr(MSR_APIC_BASE, msr | APIC_BASE_ENABLE);
+    lapic_write(LAPIC_LVT_LINT0, LVT_EXTINT);
+    lapic_write(LAPIC_LVT_LINT1, LVT_NMI);
+    lapic_write(LAPIC_SVR, SVR_ENABLE | LAPIC_SPURIOUS);
+    cpus[0].apic_id = lapic_read(LAPIC_ID) >> 24;
+
+    if (listed < 2) return;
+
+    asm volatile("sgdt %0" : "=m"(boot_gdtr));
+    asm volatile("sidt %0" : "=m"(boot_idtr));
+    mtrr_save();
+
+    // Borrow the page: GRUB may have left multiboot structures in it
+    uint8_t* tramp = (uint8_t*)AP_TRAMPOLINE;
+    uint32_t size = ap_trampoline_end - ap_trampoline;
+    for (uint32_t i = 0; i < size; i++) {
+        trampoline_saved[i] = tramp[i];
+        tramp[i] = ap_trampoline[i];
+    }
+    *(DescPtr*)(tramp + (ap_gdt_ptr - ap_trampoline)) = boot_gdtr;
+    *(uint32_t*)(tramp + (ap_entry - ap_trampoline)) = (uint32_t)ap_main;
+
+    for (int i = 0; i < listed && i < SMP_MAX_CPUS && cpu_count < SMP_MAX_CPUS; i++) {
+        if (ids[i] == cpus[0].apic_id) continue;
+
+        CpuData* c = &cpus[cpu_count];
+        c->index = cpu_count;
+        c->apic_id = ids[i];
+        c->online = 0;
+        c->jobs = 0;
+        c->stack = pmm_alloc(SMP_STACK_SIZE);
+        if (!c->stack) break;
+
+        if (start_ap(c)) {
+            cpu_count++;
+        } else {
+            pmm_free(c->stack, SMP_STACK_SIZE);
+        }
+    }
+
+    for (uint32_t i = 0; i < size; i++) tramp[i] = trampoline_saved[i];
+}
+
+CpuData* this_cpu(void) {
+    if (cpu_count > 1) {
+        uint8_t id = lapic_read(LAPIC_ID) >> 24;
+        for (int i = 1; i < cpu_count; i++) {
+            if (cpus[i].apic_id == id) return &cpus[i];
+        }
+    }
+    return &cpus[0];
+}
+
+// --- Jobs ---
+
+void smp_submit(SmpGroup* g, smp_job_fn fn, void* arg) {
+    Job j = { fn, arg, g };
+    __sync_fetch_and_add(&g->pending, 1);
+
+    int queued = 0;
+    if (cpu_count > 1) {
+        queue_acquire();
+        if (queue_head - queue_tail < SMP_QUEUE_SIZE) {
+            queue[queue_head % SMP_QUEUE_SIZE] = j;
+            queue_head++;
+            queued = 1;
+        }
+        queue_release();
+    }
+
+    if (queued) {
+        send_ipi(0, ICR_ALL_BUT_SELF | ICR_ASSERT | ICR_FIXED | SMP_WAKE_VECTOR);
+    } else {
+        run_job(this_cpu(), &j);
+    }
+}
+
+void smp_wait(SmpGroup* g) {
+    CpuData* c = this_cpu();
+    while (g->pending) {
+        Job j;
+        if (take_job(&j)) {
+            run_job(c, &j);
+        } else {
+            cpu_relax();
+        }
+    }
+}
+
+// --- Report ---
+
+static char* append(char* dst, const char* src) {
+    while (*src) *dst++ = *src++;
+    *dst = '\0';
+    return dst;
+}
+
+static char* append_u32(char* dst, uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do { tmp[n++] = '0' + v % 10; v /= 10; } while (v);
+    while (n) *dst++ = tmp[--n];
+    *dst = '\0';
+    return dst;
+}
+
+void smp_report(void (*print)(const char*)) {
+    char line[80];
+    char* p = append(line, "SMP: ");
+    p = append_u32(p, cpu_count);
+    p = append(p, " of ");
+    p = append_u32(p, smp_cpus_listed);
+    p = append(p, lapic_base ? " CPUs online" : " CPUs online, no MADT");
+    print(line);
+
+    for (int i = 0; i < cpu_count; i++) {
+        p = append(line, "CPU");
+        p = append_u32(p, cpus[i].index);
+        p = append(p, " (APIC ");
+        p = append_u32(p, cpus[i].apic_id);
+        p = append(p, i ? "): " : ", boot): ");
+        p = append_u32(p, cpus[i].jobs);
+        p = append(p, " jobs");
+        print(line);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include <stdint.h>
+
+// --- Multiprocessor Support ---
+// The application processors listed in the ACPI MADT are started with
+// INIT-SIPI-SIPI. Each one gets its own stack and CpuData. It then
+// sleeps in hlt until the boot CPU queues a job and sends a wake IPI.
+// Jobs run with interrupts off and must not touch the PS/2, disk or
+// network drivers or the heap, which all assume a single CPU.
+
+#define SMP_MAX_CPUS     16
+#define SMP_STACK_SIZE   16384
+#define SMP_QUEUE_SIZE   64
+
+// IDT vectors, also set up by idt_install
+#define SMP_WAKE_VECTOR  0xF0
+#define LAPIC_SPURIOUS   0xFF
+
+typedef struct {
+    uint32_t index;           // 0 is the boot CPU
+    uint8_t apic_id;
+    volatile uint8_t online;
+    uint32_t stack;           // base of the SMP_STACK_SIZE block
+    volatile uint32_t jobs;   // jobs run since boot
+} CpuData;
+
+typedef void (*smp_job_fn)(void* arg);
+
+// Completion counter for a batch of jobs
+typedef struct {
+    volatile uint32_t pending;
+} SmpGroup;
+
+extern CpuData cpus[SMP_MAX_CPUS];
+extern int cpu_count;        // online CPUs, the boot CPU included
+extern int smp_cpus_listed;  // enabled processors in the MADT
+
+// Find the MADT, map the local APIC and start every listed AP. Needs the
+// timer running and paging on, and must come after the last paging_map.
+void smp_init(void);
+
+// Data of the calling CPU
+CpuData* this_cpu(void);
+
+// Queue fn(arg) as part of g. Without APs, or with the queue full, it
+// runs right here instead.
+void smp_submit(SmpGroup* g, smp_job_fn fn, void* arg);
+
+// Wait for every job in g, running queued jobs on this CPU meanwhile
+void smp_wait(SmpGroup* g);
+
+// MADT summary and per-CPU job counts
+void smp_report(void (*print)(const char*));
+
+#endif
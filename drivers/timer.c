@@ -0,0 +1,183 @@
+#include "timer.h"
+#include "cpu.h"
+#include "pic.h"
+
+static inline void outb(uint16_t port, uint8_t val) {
+    asm volatile ( "outb %0, %1" : : "a"(val), "Nd"(port) );
+}
+
+static inline uint8_t inb(uint16_t port) {
+    uint8_t ret;
+    asm volatile ( "inb %1, %0" : "=a"(ret) : "Nd"(port) );
+    return ret;
+}
+
+uint32_t tsc_khz = 0;
+
+#define CALIBRATE_MS 10
+
+void timer_calibrate_tsc(void) {
+    if (!cpu_has(CPU_FEAT_TSC)) return;
+
+    uint16_t count = PIT_HZ / (1000 / CALIBRATE_MS);
+
+    // Gate low, speaker off while the channel is programmed
+    uint8_t port61 = inb(0x61);
+    outb(0x61, port61 & ~0x03);
+
+    outb(0x43, 0xB0); // Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count)
+    outb(0x42, count & 0xFF);
+    outb(0x42, count >> 8);
+
+    // Raising the gate starts the count; OUT2 (bit 5) goes high at zero
+    outb(0x61, (port61 & ~0x02) | 0x01);
+    uint64_t t0 = rdtsc();
+    uint32_t spins = 0;
+    int expired = 0;
+    while (spins++ < 0x10000000) {
+        if (inb(0x61) & 0x20) { expired = 1; break; }
+    }
+    uint64_t t1 = rdtsc();
+
+    outb(0x61, port61);
+    if (!expired) return; // channel 2 not wired up
+
+    // 10 ms fits in 32 bits below 400 GHz
+    tsc_khz = (uint32_t)(t1 - t0) / CALIBRATE_MS;
+}
+
+// --- Timer Interrupt ---
+#define PIT_DIVISOR ((PIT_HZ + TIMER_HZ / 2) / TIMER_HZ)
+
+static volatile uint32_t irq_ticks;
+
+static void timer_irq(void) {
+    irq_ticks++;
+}
+
+uint32_t ticks(void) {
+    return irq_ticks;
+}
+
+// --- Monotonic Clock ---
+uint32_t timer_ticks_per_ms = 0;
+
+static uint64_t clock_base;
+static uint64_t pit_last_now;
+
+static uint16_t pit_read_ch0(void) {
+    outb(0x43, 0x00); // Latch channel 0
+    uint8_t lo = inb(0x40);
+    uint8_t hi = inb(0x40);
+    return (uint16_t)((hi << 8) | lo);
+}
+
+void timer_init(void) {
+    // Mode 2 counts down by one per input clock and pulses IRQ0 on reload,
+    // unlike the BIOS square wave mode that steps by two
+    outb(0x43, 0x34); // Channel 0, lobyte/hibyte, mode 2
+    outb(0x40, PIT_DIVISOR & 0xFF);
+    outb(0x40, PIT_DIVISOR >> 8);
+    irq_install_handler(0, timer_irq);
+
+    // Without a TSC the clock counts PIT input cycles: whole interrupts
+    // plus however far the counter is into the current one
+    timer_ticks_per_ms = tsc_khz ? tsc_khz : PIT_DIVISOR * TIMER_HZ / 1000;
+    clock_base = timer_now();
+}
+
+uint64_t timer_now(void) {
+    if (tsc_khz) return rdtsc();
+
+    uint32_t t;
+    uint16_t count;
+    do {
+        t = irq_ticks;
+        count = pit_read_ch0();
+    } while (t != irq_ticks);
+
+    // A reload that has not been serviced yet would read as a step back
+    uint64_t now = (uint64_t)t * PIT_DIVISOR + (PIT_DIVISOR - count);
+    if (now < pit_last_now) now = pit_last_now;
+    pit_last_now = now;
+    return now;
+}
+
+// 64-by-32 divide from two 32-bit divides; no libgcc for __udivdi3
+static uint64_t div64_32(uint64_t n, uint32_t d, uint32_t* rem) {
+    uint32_t qhi, qlo, r;
+    asm("divl %2" : "=a"(qhi), "=d"(r) : "rm"(d), "0"((uint32_t)(n >> 32)), "1"(0));
+    asm("divl %2" : "=a"(qlo), "=d"(r) : "rm"(d), "0"((uint32_t)n), "1"(r));
+    if (rem) *rem = r;
+    return ((uint64_t)qhi << 32) | qlo;
+}
+
+uint64_t now_ns(void) {
+    if (!timer_ticks_per_ms) return 0;
+    uint32_t r;
+    uint64_t ms = div64_32(timer_now() - clock_base, timer_ticks_per_ms, &r);
+    return ms * NS_PER_MS + div64_32((uint64_t)r * NS_PER_MS, timer_ticks_per_ms, 0);
+}
+
+void sleep_until(uint64_t deadline_ns) {
+    // With interrupts off nothing would wake a hlt
+    if (!interrupts_enabled()) {
+        while (now_ns() < deadline_ns) asm volatile("rep; nop");
+        return;
+    }
+    while (1) {
+        asm volatile("cli");
+        if (now_ns() >= deadline_ns) break;
+        idle_halt();
+    }
+    asm volatile("sti");
+}
+
+// --- Idle Accounting ---
+static uint64_t idle_window_start;
+static uint64_t idle_window_halted;
+static uint32_t idle_last_percent;
+
+// Close the measuring window once it spans a second
+static void idle_roll(uint64_t now) {
+    if (!idle_window_start) {
+        idle_window_start = now;
+        return;
+    }
+    uint64_t span = now - idle_window_start;
+    if (span < (uint64_t)timer_ticks_per_ms * 1000) return;
+
+    uint32_t span_ms = (uint32_t)div64_32(span, timer_ticks_per_ms, 0);
+    uint32_t halted_ms = (uint32_t)div64_32(idle_window_halted, timer_ticks_per_ms, 0);
+    idle_last_percent = halted_ms * 100 / span_ms;
+    idle_window_start = now;
+    idle_window_halted = 0;
+}
+
+void idle_halt(void) {
+    uint64_t t0 = timer_now();
+    // sti takes effect after the next instruction, so a wakeup that
+    // arrives after the caller's last check still ends this hlt
+    asm volatile("sti; hlt");
+    uint64_t t1 = timer_now();
+    if (!timer_ticks_per_ms) return;
+    idle_window_halted += t1 - t0;
+    idle_roll(t1);
+}
+
+uint32_t idle_percent(void) {
+    if (!timer_ticks_per_ms) return 0;
+    idle_roll(timer_now());
+    return idle_last_percent;
+}
+
+uint32_t timer_ticks_to_us(uint32_t delta) {
+    if (!timer_ticks_per_ms) return 0;
+    // 64-bit product, 32-bit quotient; no libgcc for a 64-bit divide
+    uint32_t lo, hi, q, r;
+    asm("mull %2" : "=a"(lo), "=d"(hi) : "rm"((uint32_t)1000), "0"(delta));
+    if (hi >= timer_ticks_per_ms) return 0xFFFFFFFF;
+    asm("divl %2" : "=a"(q), "=d"(r) : "rm"(timer_ticks_per_ms), "0"(lo), "1"(hi));
+    (void)r;
+    return q;
+}
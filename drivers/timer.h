@@ -0,0 +1,62 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+// PIT input clock in Hz
+#define PIT_HZ 1193182
+
+// TSC ticks per millisecond, 0 if there is no TSC or it wasn't measured
+extern uint32_t tsc_khz;
+
+// Measure the TSC against a 10 ms one-shot on PIT channel 2 (the speaker
+// gate), which needs no interrupts.
+void timer_calibrate_tsc(void);
+
+// --- Timer Interrupt ---
+// PIT channel 0 raises IRQ0 TIMER_HZ times a second once timer_init has
+// run and interrupts are on.
+#define TIMER_HZ 1000
+
+// Timer interrupts since boot; one per millisecond
+uint32_t ticks(void);
+
+// --- Monotonic Clock ---
+// Runs on the TSC once it is calibrated, otherwise on the IRQ0 count
+// refined by the PIT counter. The PIT fallback only advances while
+// interrupts are on.
+
+#define NS_PER_MS 1000000ULL
+
+// Clock ticks per millisecond
+extern uint32_t timer_ticks_per_ms;
+
+// Program the timer interrupt and pick the clock source. Call after
+// timer_calibrate_tsc and pic_init.
+void timer_init(void);
+
+uint64_t timer_now(void);
+
+// Nanoseconds since timer_init
+uint64_t now_ns(void);
+
+// Wait for now_ns() to reach a deadline, halting between interrupts
+void sleep_until(uint64_t deadline_ns);
+
+// --- Idle ---
+// Halt until the next interrupt and count the time as idle. Call with
+// interrupts off after checking there is no work; returns with them on.
+void idle_halt(void);
+
+// Share of the last whole second spent in idle_halt
+uint32_t idle_percent(void);
+
+// Deadline for a timeout loop, `ms` from now
+static inline uint64_t timer_deadline(uint32_t ms) {
+    return now_ns() + ms * NS_PER_MS;
+}
+
+// Convert a tick delta (below about a second) to microseconds
+uint32_t timer_ticks_to_us(uint32_t delta);
+
+#endif
@@ -0,0 +1,347 @@
+#include "bench.h"
+#include "span.h"
+#include "blend.h"
+#include "text.h"
+#include "../font.h"
+#include "../drivers/cpu.h"
+#include "../drivers/timer.h"
+#include "../drivers/mtrr.h"
+#include "../drivers/bga.h"
+#include "pixfmt.h"
+#include "blur.h"
+#include "wallpaper.h"
+
+void draw_pixel(int x, int y, uint32_t color);
+void swap_buffers(void);
+void draw_rect_alpha(int x, int y, int w, int h, uint32_t color, uint8_t alpha);
+
+#define BENCH_RUNS 4
+
+// The fill loop draw_rect used before the span engine, kept as the baseline
+static void fill_per_pixel(int x, int y, int w, int h, uint32_t color) {
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+            draw_pixel(x + j, y + i, color);
+        }
+    }
+}
+
+static void u32_to_str(uint32_t v, char* out) {
+    char tmp[12];
+    int n = 0;
+    do { tmp[n++] = '0' + (v % 10); v /= 10; } while (v);
+    while (n) *out++ = tmp[--n];
+    *out = 0;
+}
+
+static char* append(char* dst, const char* src) {
+    while (*src) *dst++ = *src++;
+    *dst = 0;
+    return dst;
+}
+
+static char* append_u32(char* dst, uint32_t v) {
+    char num[12];
+    u32_to_str(v, num);
+    return append(dst, num);
+}
+
+// Best-of-N cycle count for one fill routine
+static uint32_t time_fill(void (*fill)(int, int, int, int, uint32_t), int w, int h) {
+    uint32_t best = 0xFFFFFFFF;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t t0 = rdtsc();
+        fill(0, 0, w, h, 0x00102030 + run);
+        uint64_t t1 = rdtsc();
+        uint32_t dt = (uint32_t)(t1 - t0);
+        if (dt < best) best = dt;
+    }
+    return best;
+}
+
+static void bench_case(bench_print_fn print, const char* name, int w, int h) {
+    uint32_t slow = time_fill(fill_per_pixel, w, h);
+    uint32_t fast = time_fill(gfx_fill_rect, w, h);
+    if (fast == 0) fast = 1;
+
+    char line[80];
+    char* p = append(line, name);
+    p = append(p, " per-pixel ");
+    p = append_u32(p, slow);
+    p = append(p, " cyc, span ");
+    p = append_u32(p, fast);
+    p = append(p, " cyc (x");
+    p = append_u32(p, slow / fast);
+    p = append(p, ")");
+    print(line);
+}
+
+void gfx_bench_fill(bench_print_fn print) {
+    if (!backbuffer) {
+        print("gfxbench: no framebuffer.");
+        return;
+    }
+    if (!cpu_has(CPU_FEAT_TSC)) {
+        print("gfxbench: CPU has no TSC.");
+        return;
+    }
+
+    gfx_clip_reset();
+    bench_case(print, "Full screen:", (int)scr_width, (int)scr_height);
+    bench_case(print, "Rect 32x32: ", 32, 32);
+    bench_case(print, "Rect 8x8:   ", 8, 8);
+}
+
+void gfx_bench_blend(bench_print_fn print) {
+    if (!backbuffer || !cpu_has(CPU_FEAT_TSC)) return;
+
+    int w = (int)scr_width;
+    int h = (int)scr_height;
+    for (int t = 0; t < BLEND_TIER_COUNT; t++) {
+        if (!blend_tiers[t].usable) continue;
+
+        uint32_t best = 0xFFFFFFFF;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            uint64_t t0 = rdtsc();
+            for (int y = 0; y < h; y++) {
+                blend_tiers[t].fn(gfx_row(y), w, 0x00303030, 160);
+            }
+            uint64_t t1 = rdtsc();
+            uint32_t dt = (uint32_t)(t1 - t0);
+            if (dt < best) best = dt;
+        }
+
+        char line[80];
+        char* p = append(line, "Blend ");
+        p = append(p, blend_tiers[t].name);
+        p = append(p, t == blend_active_tier ? " (active): " : ": ");
+        p = append_u32(p, best);
+        p = append(p, " cyc");
+        print(line);
+    }
+}
+
+// The bit-testing glyph loop draw_char used before the mask tables
+static void text_per_pixel(const char* str, int x, int y, uint32_t fg) {
+    for (; *str; str++, x += 8) {
+        if (*str < 0) continue;
+        const uint8_t* glyph = font8x8[(int)*str];
+        for (int row = 0; row < 8; row++) {
+            for (int col = 0; col < 8; col++) {
+                if (glyph[row] & (1 << (7 - col))) draw_pixel(x + col, y + row, fg);
+            }
+        }
+    }
+}
+
+static const char bench_text[] = "The quick brown fox jumps over the lazy dog 0123456789";
+
+void gfx_bench_text(bench_print_fn print) {
+    if (!backbuffer || !cpu_has(CPU_FEAT_TSC)) return;
+
+    // One screenful of text rows, as a terminal or browser redraw would do
+    int rows = (int)scr_height / 10;
+    uint32_t best[2] = {0xFFFFFFFF, 0xFFFFFFFF};
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t t0 = rdtsc();
+        for (int r = 0; r < rows; r++) text_per_pixel(bench_text, 0, r * 10, 0xC8D0D8);
+        uint64_t t1 = rdtsc();
+        for (int r = 0; r < rows; r++) draw_text_run(bench_text, -1, 0, r * 10, 0xC8D0D8);
+        uint64_t t2 = rdtsc();
+
+        uint32_t dt[2] = {(uint32_t)(t1 - t0), (uint32_t)(t2 - t1)};
+        for (int i = 0; i < 2; i++) if (dt[i] < best[i]) best[i] = dt[i];
+    }
+
+    char line[80];
+    char* p = append(line, "Text per-pixel ");
+    p = append_u32(p, best[0]);
+    p = append(p, " cyc, run ");
+    p = append_u32(p, best[1]);
+    p = append(p, " cyc");
+    print(line);
+}
+
+void gfx_bench_present(bench_print_fn print) {
+    if (!fb || !backbuffer || backbuffer == fb || !cpu_has(CPU_FEAT_TSC)) return;
+
+    char line[80];
+    char* p = append(line, "Framebuffer: ");
+    p = append(p, fb_format->name);
+    p = append(p, ", ");
+    p = append(p, mtrr_status_str(mtrr_fb_status));
+    print(line);
+
+    if (bga_page_count) {
+        // Frames are flipped, not copied; there is no present copy to time
+        p = append(line, "Present: BGA page flip, ");
+        p = append_u32(p, bga_page_count);
+        p = append(p, " pages");
+        print(line);
+        return;
+    }
+
+    uint32_t best = 0xFFFFFFFF;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t t0 = rdtsc();
+        swap_buffers();
+        uint64_t t1 = rdtsc();
+        uint32_t dt = (uint32_t)(t1 - t0);
+        if (dt < best) best = dt;
+    }
+
+    p = append(line, "Present: ");
+    p = append_u32(p, best);
+    p = append(p, " cyc");
+
+    // Bytes per microsecond is MB/s
+    uint32_t mhz = tsc_khz / 1000;
+    if (mhz) {
+        uint32_t us = best / mhz;
+        if (us == 0) us = 1;
+        p = append(p, ", ");
+        p = append_u32(p, us);
+        p = append(p, " us, ");
+        p = append_u32(p, (scr_height * scr_width * fb_format->bytes_pp) / us);
+        p = append(p, " MB/s");
+    }
+    print(line);
+}
+
+// --- Primitive Suite ---
+// One line per primitive and size: best-of-N cycles for a call, cycles
+// per pixel to two decimals, and MB/s of 32bpp pixels written.
+
+typedef struct {
+    const char* name;
+    int w, h;
+} BenchSize;
+
+static const BenchSize suite_sizes[] = {
+    {"16x16", 16, 16},
+    {"64x64", 64, 64},
+    {"256x256", 256, 256},
+    {"full", 0, 0},
+};
+
+#define SUITE_SIZES (int)(sizeof(suite_sizes) / sizeof(suite_sizes[0]))
+
+// a * b / c through a 64-bit product; the quotient must fit in 32 bits
+static uint32_t mul_div(uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t lo, hi, q, r;
+    asm("mull %2" : "=a"(lo), "=d"(hi) : "rm"(b), "0"(a));
+    if (hi >= c) return 0xFFFFFFFF;
+    asm("divl %2" : "=a"(q), "=d"(r) : "rm"(c), "0"(lo), "1"(hi));
+    (void)r;
+    return q;
+}
+
+static int suite_w, suite_h;
+static uint32_t suite_arg;
+
+static void prim_rect(void) { gfx_fill_rect(0, 0, suite_w, suite_h, 0x00336699 + suite_arg); }
+static void prim_rect_alpha(void) { draw_rect_alpha(0, 0, suite_w, suite_h, 0x00336699, 160); }
+static void prim_blur(void) { gfx_blur_rect(0, 0, suite_w, suite_h, BLUR_RADIUS); }
+static void prim_wallpaper(void) { wallpaper_draw(0x282C34); }
+static void prim_swap(void) { swap_buffers(); }
+
+// Rows of text filling suite_w x suite_h
+static void prim_string(void) {
+    const int len = (int)sizeof(bench_text) - 1;
+    for (int y = 0; y + 8 <= suite_h; y += 8) {
+        for (int x = 0; x < suite_w; x += len * 8) {
+            int chars = (suite_w - x) / 8;
+            draw_text_run(bench_text, chars < len ? chars : len, x, y, 0xC8D0D8);
+        }
+    }
+}
+
+static void suite_case(bench_print_fn print, const char* name, void (*prim)(void),
+                       const BenchSize* size) {
+    suite_w = size->w ? size->w : (int)scr_width;
+    suite_h = size->h ? size->h : (int)scr_height;
+    uint32_t pixels = (uint32_t)suite_w * suite_h;
+
+    // Repeat small cases so each sample is long enough to time
+    uint32_t reps = 65536 / pixels;
+    if (reps == 0) reps = 1;
+
+    uint32_t best = 0xFFFFFFFF;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t t0 = rdtsc();
+        for (uint32_t i = 0; i < reps; i++) {
+            suite_arg = i;
+            prim();
+        }
+        uint64_t t1 = rdtsc();
+        uint32_t dt = (uint32_t)(t1 - t0) / reps;
+        if (dt < best) best = dt;
+    }
+    if (best == 0) best = 1;
+
+    char line[80];
+    char* p = append(line, name);
+    p = append(p, " ");
+    p = append(p, size->name);
+    p = append(p, ": ");
+    p = append_u32(p, best);
+    p = append(p, " cyc, ");
+
+    uint32_t cpp100 = mul_div(best, 100, pixels);
+    p = append_u32(p, cpp100 / 100);
+    p = append(p, ".");
+    if (cpp100 % 100 < 10) p = append(p, "0");
+    p = append_u32(p, cpp100 % 100);
+    p = append(p, " cyc/px");
+
+    // Bytes per microsecond is MB/s
+    uint32_t mhz = tsc_khz / 1000;
+    if (mhz) {
+        p = append(p, ", ");
+        p = append_u32(p, mul_div(pixels * 4, mhz, best));
+        p = append(p, " MB/s");
+    }
+    print(line);
+}
+
+void gfx_bench_suite(bench_print_fn print) {
+    if (!backbuffer) {
+        print("gfxbench: no framebuffer.");
+        return;
+    }
+    if (!cpu_has(CPU_FEAT_TSC)) {
+        print("gfxbench: CPU has no TSC.");
+        return;
+    }
+
+    char line[80];
+    char* p = append(line, "Screen ");
+    p = append_u32(p, scr_width);
+    p = append(p, "x");
+    p = append_u32(p, scr_height);
+    p = append(p, " ");
+    p = append(p, fb_format->name);
+    p = append(p, ", TSC ");
+    p = append_u32(p, tsc_khz / 1000);
+    p = append(p, " MHz, blend ");
+    p = append(p, blend_tiers[blend_active_tier].name);
+    print(line);
+
+    gfx_clip_reset();
+    for (int i = 0; i < SUITE_SIZES; i++) suite_case(print, "draw_rect", prim_rect, &suite_sizes[i]);
+    for (int i = 0; i < SUITE_SIZES; i++) suite_case(print, "draw_rect_alpha", prim_rect_alpha, &suite_sizes[i]);
+    for (int i = 0; i < SUITE_SIZES; i++) suite_case(print, "blur_rect", prim_blur, &suite_sizes[i]);
+    for (int i = 0; i < SUITE_SIZES; i++) suite_case(print, "draw_string", prim_string, &suite_sizes[i]);
+
+    const BenchSize* full = &suite_sizes[SUITE_SIZES - 1];
+    if (wallpaper_draw(0x282C34)) {
+        suite_case(print, "draw_wallpaper", prim_wallpaper, full);
+    } else {
+        print("draw_wallpaper: no wallpaper loaded");
+    }
+    if (bga_page_count) {
+        print("swap_buffers: frames are flipped, not copied");
+    } else if (fb && backbuffer != fb) {
+        suite_case(print, "swap_buffers", prim_swap, full);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef GFX_BENCH_H
+#define GFX_BENCH_H
+
+typedef void (*bench_print_fn)(const char* line);
+
+// Times the span fill engine against the old per-pixel loop and prints
+// one line per case. Scribbles over the backbuffer; callers redraw after.
+void gfx_bench_fill(bench_print_fn print);
+
+// Times every usable alpha-blend tier over a full-screen span.
+void gfx_bench_blend(bench_print_fn print);
+
+// Times a screenful of text through the old bit-test loop and draw_text_run.
+void gfx_bench_text(bench_print_fn print);
+
+// Reports the framebuffer cache type and times a full present to VRAM.
+void gfx_bench_present(bench_print_fn print);
+
+// Times draw_rect, draw_rect_alpha, blur_rect, draw_string,
+// draw_wallpaper and swap_buffers at several sizes for boot-time
+// benchmark runs, in cycles per pixel and MB/s.
+void gfx_bench_suite(bench_print_fn print);
+
+#endif
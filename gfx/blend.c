@@ -0,0 +1,156 @@
+#include "blend.h"
+#include "../drivers/cpu.h"
+
+// --- SWAR Tier ---
+// R and B share one 32-bit multiply: each channel product is at most
+// 255 * 255 = 65025, so the blue sum never carries into red's byte.
+// G gets the second multiply.
+static void blend_span_swar(uint32_t* dst, int count, uint32_t color, uint8_t alpha) {
+    uint32_t inv = 255 - alpha;
+    uint32_t src_rb = (color & 0x00FF00FF) * alpha;
+    uint32_t src_g = (color & 0x0000FF00) * alpha;
+
+    for (int i = 0; i < count; i++) {
+        uint32_t d = dst[i];
+        uint32_t rb = (((d & 0x00FF00FF) * inv + src_rb) >> 8) & 0x00FF00FF;
+        uint32_t g = (((d & 0x0000FF00) * inv + src_g) >> 8) & 0x0000FF00;
+        dst[i] = rb | g;
+    }
+}
+
+// Per-channel constants for the SIMD tiers, laid out as B, G, R, X words
+// to match an unpacked little-endian XRGB pixel.
+static uint16_t simd_src[8] __attribute__((aligned(16)));
+static uint16_t simd_inv[8] __attribute__((aligned(16)));
+static const uint32_t simd_rgb_mask[4] __attribute__((aligned(16))) = {
+    0x00FFFFFF, 0x00FFFFFF, 0x00FFFFFF, 0x00FFFFFF
+};
+
+static void simd_setup(uint32_t color, uint8_t alpha) {
+    uint16_t b = (color & 0xFF) * alpha;
+    uint16_t g = ((color >> 8) & 0xFF) * alpha;
+    uint16_t r = ((color >> 16) & 0xFF) * alpha;
+    for (int i = 0; i < 8; i += 4) {
+        simd_src[i] = b; simd_src[i + 1] = g; simd_src[i + 2] = r; simd_src[i + 3] = 0;
+        for (int k = 0; k < 4; k++) simd_inv[i + k] = 255 - alpha;
+    }
+}
+
+// --- MMX Tier ---
+// Two pixels per iteration. Every word stays below 65026 so pmullw,
+// paddw and psrlw give exactly the scalar result.
+__attribute__((target("mmx")))
+static void blend_span_mmx(uint32_t* dst, int count, uint32_t color, uint8_t alpha) {
+    simd_setup(color, alpha);
+
+    int pairs = count >> 1;
+    if (pairs) {
+        asm volatile(
+            "pxor %%mm7, %%mm7\n"
+            "movq (%2), %%mm6\n"
+            "movq (%3), %%mm5\n"
+            "movq (%4), %%mm4\n"
+            "1:\n"
+            "movq (%0), %%mm0\n"
+            "movq %%mm0, %%mm1\n"
+            "punpcklbw %%mm7, %%mm0\n"
+            "punpckhbw %%mm7, %%mm1\n"
+            "pmullw %%mm6, %%mm0\n"
+            "pmullw %%mm6, %%mm1\n"
+            "paddw %%mm5, %%mm0\n"
+            "paddw %%mm5, %%mm1\n"
+            "psrlw $8, %%mm0\n"
+            "psrlw $8, %%mm1\n"
+            "packuswb %%mm1, %%mm0\n"
+            "pand %%mm4, %%mm0\n"
+            "movq %%mm0, (%0)\n"
+            "addl $8, %0\n"
+            "decl %1\n"
+            "jnz 1b\n"
+            "emms\n"
+            : "+r"(dst), "+r"(pairs)
+            : "r"(simd_inv), "r"(simd_src), "r"(simd_rgb_mask)
+            : "memory", "cc", "mm0", "mm1", "mm4", "mm5", "mm6", "mm7");
+    }
+
+    if (count & 1) blend_span_swar(dst, 1, color, alpha);
+}
+
+// --- SSE2 Tier ---
+// Four pixels per iteration, same arithmetic as the MMX tier.
+__attribute__((target("sse2")))
+static void blend_span_sse2(uint32_t* dst, int count, uint32_t color, uint8_t alpha) {
+    simd_setup(color, alpha);
+
+    int quads = count >> 2;
+    if (quads) {
+        asm volatile(
+            "pxor %%xmm7, %%xmm7\n"
+            "movdqa (%2), %%xmm6\n"
+            "movdqa (%3), %%xmm5\n"
+            "movdqa (%4), %%xmm4\n"
+            "1:\n"
+            "movdqu (%0), %%xmm0\n"
+            "movdqa %%xmm0, %%xmm1\n"
+            "punpcklbw %%xmm7, %%xmm0\n"
+            "punpckhbw %%xmm7, %%xmm1\n"
+            "pmullw %%xmm6, %%xmm0\n"
+            "pmullw %%xmm6, %%xmm1\n"
+            "paddw %%xmm5, %%xmm0\n"
+            "paddw %%xmm5, %%xmm1\n"
+            "psrlw $8, %%xmm0\n"
+            "psrlw $8, %%xmm1\n"
+            "packuswb %%xmm1, %%xmm0\n"
+            "pand %%xmm4, %%xmm0\n"
+            "movdqu %%xmm0, (%0)\n"
+            "addl $16, %0\n"
+            "decl %1\n"
+            "jnz 1b\n"
+            : "+r"(dst), "+r"(quads)
+            : "r"(simd_inv), "r"(simd_src), "r"(simd_rgb_mask)
+            : "memory", "cc", "xmm0", "xmm1", "xmm4", "xmm5", "xmm6", "xmm7");
+    }
+
+    if (count & 3) blend_span_swar(dst, count & 3, color, alpha);
+}
+
+BlendTier blend_tiers[BLEND_TIER_COUNT] = {
+    {"SWAR", blend_span_swar, 1},
+    {"MMX",  blend_span_mmx,  0},
+    {"SSE2", blend_span_sse2, 0},
+};
+
+blend_span_fn gfx_blend_span = blend_span_swar;
+int blend_active_tier = BLEND_TIER_SWAR;
+
+// Checks a tier against the reference formula on a spread of inputs
+// before trusting it; a mismatch leaves the tier disabled.
+static int blend_selftest(blend_span_fn fn) {
+    static const uint8_t alphas[] = {1, 40, 90, 100, 128, 160, 230, 254};
+    uint32_t buf[13];
+    for (unsigned a = 0; a < sizeof(alphas); a++) {
+        uint32_t color = 0x00A1B2C3 ^ (a * 0x00372911);
+        for (int i = 0; i < 13; i++) buf[i] = 0xFF000000u | ((i * 0x00131F29u) ^ (a << 5));
+        fn(buf, 13, color, alphas[a]);
+        for (int i = 0; i < 13; i++) {
+            uint32_t d = 0xFF000000u | ((i * 0x00131F29u) ^ (a << 5));
+            if (buf[i] != blend_pixel(d, color, alphas[a])) return 0;
+        }
+    }
+    return 1;
+}
+
+void blend_init(void) {
+    if (cpu_simd_enabled & CPU_SIMD_MMX)
+        blend_tiers[BLEND_TIER_MMX].usable = blend_selftest(blend_span_mmx);
+    if (cpu_simd_enabled & CPU_SIMD_SSE2)
+        blend_tiers[BLEND_TIER_SSE2].usable = blend_selftest(blend_span_sse2);
+
+    for (int t = BLEND_TIER_COUNT - 1; t >= 0; t--) {
+        if (blend_tiers[t].usable) {
+            blend_active_tier = t;
+            gfx_blend_span = blend_tiers[t].fn;
+            return;
+        }
+    }
+}
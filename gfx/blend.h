@@ -0,0 +1,38 @@
+#ifndef GFX_BLEND_H
+#define GFX_BLEND_H
+
+#include <stdint.h>
+
+// Blends a solid color into count pixels:
+//   out = (src * alpha + dst * (255 - alpha)) >> 8   per channel
+// The top byte of every written pixel is cleared.
+typedef void (*blend_span_fn)(uint32_t* dst, int count, uint32_t color, uint8_t alpha);
+
+typedef struct {
+    const char* name;
+    blend_span_fn fn;
+    int usable;
+} BlendTier;
+
+#define BLEND_TIER_SWAR 0
+#define BLEND_TIER_MMX  1
+#define BLEND_TIER_SSE2 2
+#define BLEND_TIER_COUNT 3
+
+extern BlendTier blend_tiers[BLEND_TIER_COUNT];
+extern blend_span_fn gfx_blend_span;
+extern int blend_active_tier;
+
+// Picks the fastest tier the CPU supports. cpu_detect() and
+// cpu_enable_simd() must have run first.
+void blend_init(void);
+
+// Reference per-channel formula, one pixel
+static inline uint32_t blend_pixel(uint32_t dst, uint32_t color, uint8_t alpha) {
+    uint32_t res_r = (((color >> 16) & 0xFF) * alpha + ((dst >> 16) & 0xFF) * (255 - alpha)) >> 8;
+    uint32_t res_g = (((color >> 8) & 0xFF) * alpha + ((dst >> 8) & 0xFF) * (255 - alpha)) >> 8;
+    uint32_t res_b = ((color & 0xFF) * alpha + (dst & 0xFF) * (255 - alpha)) >> 8;
+    return (res_r << 16) | (res_g << 8) | res_b;
+}
+
+#endif
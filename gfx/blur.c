@@ -0,0 +1,172 @@
+#include "blur.h"
+#include "span.h"
+
+// Ring of blurred rows, column sums and halos; regions too wide for it
+// are processed in column strips
+#define BLUR_SCRATCH_PIXELS (64 * 1024)
+
+static uint32_t blur_scratch[BLUR_SCRATCH_PIXELS];
+
+static inline int clampi(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// sum * inv >> 16 divides by the tap count; inv is rounded up so a full
+// 255 window stays 255 for any radius that fits the scratch buffer
+static inline uint32_t pack_avg(uint32_t r, uint32_t g, uint32_t b, uint32_t inv) {
+    return ((r * inv >> 16) << 16) | ((g * inv >> 16) << 8) | (b * inv >> 16);
+}
+
+// One column strip of the output, shared by the row helper below
+typedef struct {
+    int cx0, cw;           // columns written by this strip
+    int left_halo;         // columns left of cx0 come from halo
+    int sx0, sx1;          // source columns, edges extended
+    int ry0, ry1;          // source rows, edges extended
+    int r, base, ring;
+    uint32_t inv;
+    uint32_t* line;        // cw + 2r + 1 padded source pixels
+    const uint32_t* halo;  // r columns per row, as they were before the
+                           // strip to the left overwrote them
+    uint32_t* hrows;       // ring of horizontally blurred rows
+} BlurStrip;
+
+static inline uint32_t* ring_row(const BlurStrip* st, int t) {
+    return st->hrows + ((t - st->base) % st->ring) * st->cw;
+}
+
+// Horizontal pass of source row clamp(t) into its ring slot
+static void blur_hrow(const BlurStrip* st, int t) {
+    int r = st->r;
+    int rr = clampi(t, st->ry0, st->ry1 - 1);
+    const uint32_t* src = gfx_row(rr);
+    const uint32_t* halo = st->halo + (rr - st->ry0) * r - (st->cx0 - r);
+    uint32_t* line = st->line;
+
+    for (int m = 0; m < st->cw + 2 * r + 1; m++) {
+        int c = clampi(st->cx0 - r + m, st->sx0, st->sx1 - 1);
+        line[m] = (st->left_halo && c < st->cx0) ? halo[c] : src[c];
+    }
+
+    uint32_t* dst = ring_row(st, t);
+    uint32_t sr = 0, sg = 0, sb = 0;
+    for (int k = 0; k <= 2 * r; k++) {
+        sr += (line[k] >> 16) & 0xFF;
+        sg += (line[k] >> 8) & 0xFF;
+        sb += line[k] & 0xFF;
+    }
+    for (int i = 0; i < st->cw; i++) {
+        dst[i] = pack_avg(sr, sg, sb, st->inv);
+        uint32_t out = line[i];
+        uint32_t in = line[i + 2 * r + 1];
+        sr += ((in >> 16) & 0xFF) - ((out >> 16) & 0xFF);
+        sg += ((in >> 8) & 0xFF) - ((out >> 8) & 0xFF);
+        sb += (in & 0xFF) - (out & 0xFF);
+    }
+}
+
+void gfx_blur_rect(int x, int y, int w, int h, int r) {
+    if (!backbuffer || r <= 0) return;
+
+    // Source: the rect on screen. Output: the part of it inside the clip.
+    int sx0 = x, sy0 = y, sx1 = x + w, sy1 = y + h;
+    if (sx0 < 0) sx0 = 0;
+    if (sy0 < 0) sy0 = 0;
+    if (sx1 > (int)scr_width) sx1 = scr_width;
+    if (sy1 > (int)scr_height) sy1 = scr_height;
+    if (sx0 < gfx_clip.x0 - r) sx0 = gfx_clip.x0 - r;
+    if (sy0 < gfx_clip.y0 - r) sy0 = gfx_clip.y0 - r;
+    if (sx1 > gfx_clip.x1 + r) sx1 = gfx_clip.x1 + r;
+    if (sy1 > gfx_clip.y1 + r) sy1 = gfx_clip.y1 + r;
+
+    int ox = x, oy = y, ow = w, oh = h;
+    if (!gfx_clip_rect(&ox, &oy, &ow, &oh)) return;
+    if (ox < sx0) { ow -= sx0 - ox; ox = sx0; }
+    if (oy < sy0) { oh -= sy0 - oy; oy = sy0; }
+    if (ox + ow > sx1) ow = sx1 - ox;
+    if (oy + oh > sy1) oh = sy1 - oy;
+    if (ow <= 0 || oh <= 0) return;
+
+    // Rows the vertical pass needs around the output
+    int ry0 = (oy - r < sy0) ? sy0 : oy - r;
+    int ry1 = (oy + oh + r > sy1) ? sy1 : oy + oh + r;
+    int rows = ry1 - ry0;
+
+    // Scratch per strip: a ring of 2r+2 horizontally blurred rows, three
+    // column sums, one padded source row and two r-column halos
+    int ring = 2 * r + 2;
+    int strip = (BLUR_SCRATCH_PIXELS - (2 * r + 1) - 2 * r * rows) / (ring + 4);
+    if (strip < r || strip <= 0) return;
+    if (strip > ow) strip = ow;
+
+    uint32_t* hrows = blur_scratch;
+    uint32_t* sum_r = hrows + ring * strip;
+    uint32_t* sum_g = sum_r + strip;
+    uint32_t* sum_b = sum_g + strip;
+    uint32_t* line = sum_b + strip;
+    uint32_t* halo = line + strip + 2 * r + 1;
+    uint32_t* next_halo = halo + r * rows;
+
+    int taps = 2 * r + 1;
+    BlurStrip st;
+    st.sx0 = sx0;
+    st.sx1 = sx1;
+    st.ry0 = ry0;
+    st.ry1 = ry1;
+    st.r = r;
+    st.base = oy - r;
+    st.ring = ring;
+    st.inv = (65536 + taps - 1) / taps;
+    st.line = line;
+    st.hrows = hrows;
+
+    for (int cx0 = ox; cx0 < ox + ow; cx0 += strip) {
+        int cw = ox + ow - cx0;
+        if (cw > strip) cw = strip;
+        st.cx0 = cx0;
+        st.cw = cw;
+        st.left_halo = cx0 > ox;
+        st.halo = halo;
+
+        // The strip to the right reads our last r columns as its left
+        // neighbours; keep them as they were before this strip is written
+        if (cx0 + cw < ox + ow) {
+            for (int j = 0; j < rows; j++) {
+                const uint32_t* src = gfx_row(ry0 + j) + cx0 + cw - r;
+                for (int k = 0; k < r; k++) next_halo[j * r + k] = src[k];
+            }
+        }
+
+        for (int i = 0; i < cw; i++) sum_r[i] = sum_g[i] = sum_b[i] = 0;
+        for (int t = oy - r; t <= oy + r; t++) {
+            blur_hrow(&st, t);
+            const uint32_t* h = ring_row(&st, t);
+            for (int i = 0; i < cw; i++) {
+                sum_r[i] += (h[i] >> 16) & 0xFF;
+                sum_g[i] += (h[i] >> 8) & 0xFF;
+                sum_b[i] += h[i] & 0xFF;
+            }
+        }
+
+        // Vertical pass, one whole row at a time so writes stay sequential.
+        // Row `row` only needs rows below it that have not been written yet.
+        for (int row = oy; row < oy + oh; row++) {
+            uint32_t* dst = gfx_row(row) + cx0;
+            for (int i = 0; i < cw; i++) dst[i] = pack_avg(sum_r[i], sum_g[i], sum_b[i], st.inv);
+            if (row + 1 == oy + oh) break;
+
+            blur_hrow(&st, row + r + 1);
+            const uint32_t* in = ring_row(&st, row + r + 1);
+            const uint32_t* out = ring_row(&st, row - r);
+            for (int i = 0; i < cw; i++) {
+                sum_r[i] += ((in[i] >> 16) & 0xFF) - ((out[i] >> 16) & 0xFF);
+                sum_g[i] += ((in[i] >> 8) & 0xFF) - ((out[i] >> 8) & 0xFF);
+                sum_b[i] += (in[i] & 0xFF) - (out[i] & 0xFF);
+            }
+        }
+
+        uint32_t* t = halo;
+        halo = next_halo;
+        next_halo = t;
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef GFX_BLUR_H
+#define GFX_BLUR_H
+
+#include <stdint.h>
+
+// Radius used by the topbar and frosted-glass titlebars
+#define BLUR_RADIUS 2
+
+// Box-blur the backbuffer inside (x, y, w, h) with a (2r+1)^2 kernel, run
+// as a horizontal then a vertical pass with running sums, so the cost per
+// pixel doesn't depend on r. Only pixels inside gfx_clip are written, but
+// neighbours up to r pixels outside it are read so partial redraws match
+// full ones. Edges of the rect are extended.
+void gfx_blur_rect(int x, int y, int w, int h, int r);
+
+#endif
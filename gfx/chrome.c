@@ -0,0 +1,114 @@
+#include "chrome.h"
+#include "span.h"
+#include "blend.h"
+
+void nine_slice_build(NineSlice* ns, int r, uint32_t color, uint8_t alpha) {
+    if (r > ROUND_MAX_R) r = ROUND_MAX_R;
+    if (r < 0) r = 0;
+
+    ns->r = r;
+    ns->color = color;
+    ns->alpha = alpha;
+    if (r > 0) {
+        const CornerTable* t = corner_table(r);
+        for (int d = 1; d <= r; d++) {
+            ns->edge[d] = t->edge[d];
+            ns->solid[d] = t->solid[d];
+            for (int j = 0; j < r; j++) {
+                ns->tile[d][j] = (uint8_t)((alpha * t->cov[d][j] + 127) / 255);
+            }
+        }
+    }
+    ns->valid = 1;
+}
+
+// Distance of row i from the centre row of its corner, 0 on straight rows.
+// Top corners win when h < 2r, as in gfx_fill_rounded.
+static inline int corner_row(int i, int h, int r) {
+    if (i < r) return r - i;
+    if (i >= h - r) return i - (h - r - 1);
+    return 0;
+}
+
+static inline void paint_span(int x0, int x1, int y, uint32_t color, uint8_t alpha) {
+    if (x0 < gfx_clip.x0) x0 = gfx_clip.x0;
+    if (x1 > gfx_clip.x1) x1 = gfx_clip.x1;
+    if (x0 >= x1) return;
+
+    uint32_t* row = gfx_row(y);
+    if (alpha == 255) {
+        gfx_fill_span(row + x0, color, x1 - x0);
+    } else {
+        gfx_blend_span(row + x0, x1 - x0, color, alpha);
+    }
+}
+
+// [x0, x1) minus the hole span [h0, h1)
+static inline void paint_span_around(int x0, int x1, int h0, int h1, int y,
+                                     uint32_t color, uint8_t alpha) {
+    if (h0 >= h1 || h1 <= x0 || h0 >= x1) {
+        paint_span(x0, x1, y, color, alpha);
+        return;
+    }
+    paint_span(x0, h0, y, color, alpha);
+    paint_span(h1, x1, y, color, alpha);
+}
+
+static inline void paint_pixel(int x, int y, int h0, int h1, uint32_t color, uint8_t alpha) {
+    if (!alpha || (x >= h0 && x < h1)) return;
+    if (x < gfx_clip.x0 || x >= gfx_clip.x1) return;
+    uint32_t* p = gfx_row(y) + x;
+    *p = blend_pixel(*p, color, alpha);
+}
+
+void nine_slice_draw(const NineSlice* ns, int x, int y, int w, int h,
+                     const GfxRect* hole, int hole_r) {
+    if (!backbuffer || !ns->valid || ns->alpha == 0 || w <= 0 || h <= 0) return;
+
+    int r = ns->r;
+    if (r > w / 2) {
+        gfx_fill_rounded(x, y, w, h, r, ns->color, ns->alpha);
+        return;
+    }
+
+    const CornerTable* ht = 0;
+    if (hole) {
+        if (hole_r > hole->w / 2) hole_r = hole->w / 2;
+        if (hole_r > 0) {
+            ht = corner_table(hole_r);
+            hole_r = ht->r;
+        } else {
+            hole_r = 0;
+        }
+    }
+
+    int row0 = (y < gfx_clip.y0) ? gfx_clip.y0 - y : 0;
+    int row1 = (y + h > gfx_clip.y1) ? gfx_clip.y1 - y : h;
+
+    for (int i = row0; i < row1; i++) {
+        int py = y + i;
+
+        // The part of this row the hole paints solid
+        int h0 = 0, h1 = 0;
+        if (hole && py >= hole->y && py < hole->y + hole->h) {
+            int hd = corner_row(py - hole->y, hole->h, hole_r);
+            int inset = hd ? ht->solid[hd] : 0;
+            h0 = hole->x + inset;
+            h1 = hole->x + hole->w - inset;
+        }
+
+        int d = corner_row(i, h, r);
+        if (d == 0) {
+            paint_span_around(x, x + w, h0, h1, py, ns->color, ns->alpha);
+            continue;
+        }
+
+        int solid = ns->solid[d];
+        paint_span_around(x + solid, x + w - solid, h0, h1, py, ns->color, ns->alpha);
+        for (int j = ns->edge[d]; j < solid; j++) {
+            uint8_t a = ns->tile[d][j];
+            paint_pixel(x + j, py, h0, h1, ns->color, a);
+            paint_pixel(x + w - 1 - j, py, h0, h1, ns->color, a);
+        }
+    }
+}
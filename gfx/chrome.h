@@ -0,0 +1,39 @@
+#ifndef GFX_CHROME_H
+#define GFX_CHROME_H
+
+#include <stdint.h>
+#include "round.h"
+#include "damage.h"
+
+// --- Nine-Slice Window Chrome ---
+// A rounded rect of one colour pre-rendered as a nine-slice: the corner
+// tile holds each pixel's final alpha (coverage times fill alpha) and is
+// mirrored for the other three corners, while the straight edges and the
+// centre are plain spans. Drawing can leave out a hole that something
+// opaque paints over afterwards, so a shadow only blends the strip that
+// stays visible around its window.
+
+typedef struct {
+    int valid;
+    int r;
+    uint32_t color;
+    uint8_t alpha;
+    uint8_t edge[ROUND_MAX_R + 1];
+    uint8_t solid[ROUND_MAX_R + 1];
+    uint8_t tile[ROUND_MAX_R + 1][ROUND_MAX_R];   // indexed like CornerTable
+} NineSlice;
+
+void nine_slice_build(NineSlice* ns, int r, uint32_t color, uint8_t alpha);
+
+static inline void nine_slice_invalidate(NineSlice* ns) {
+    ns->valid = 0;
+}
+
+// Draw ns stretched over (x, y, w, h), clipped to gfx_clip. Pixels that
+// the rounded rect (hole, hole_r) covers solidly are skipped; pass NULL
+// for no hole. Sizes too small for the corners go through
+// gfx_fill_rounded instead.
+void nine_slice_draw(const NineSlice* ns, int x, int y, int w, int h,
+                     const GfxRect* hole, int hole_r);
+
+#endif
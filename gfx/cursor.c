@@ -0,0 +1,237 @@
+#include "cursor.h"
+#include "span.h"
+#include "blend.h"
+#include "pixfmt.h"
+
+static uint32_t sprite[CURSOR_MAX_W * CURSOR_MAX_H];
+static int sprite_w, sprite_h, hot_x, hot_y;
+
+// Top-left of the sprite on screen while it is drawn
+static int cur_x, cur_y;
+static int drawn = 0;
+static int direct = 0;
+
+// An old and a new position are repaired together when they overlap
+static uint32_t scratch[CURSOR_MAX_W * 2 * CURSOR_MAX_H * 2];
+
+// Direct mode: the sprite drawn into a page, and the pixels it covers.
+// Page flipping puts it on the next page before the old one is cleaned,
+// so there are two.
+typedef struct {
+    uint32_t* page;
+    int x, y;
+    int drawn;
+    uint32_t pixels[CURSOR_MAX_W * CURSOR_MAX_H];
+} SaveUnder;
+
+static SaveUnder saves[2];
+static int front_save = 0;
+
+// --- Default Arrow ---
+// X outline, o fill; a soft drop shadow is added when it's loaded
+static const char* const arrow_map[] = {
+    "X           ",
+    "XX          ",
+    "XoX         ",
+    "XooX        ",
+    "XoooX       ",
+    "XooooX      ",
+    "XoooooX     ",
+    "XooooooX    ",
+    "XoooooooX   ",
+    "XooooooooX  ",
+    "XoooooooooX ",
+    "XooooooXXXXX",
+    "XoooXooX    ",
+    "XooX XooX   ",
+    "XoX  XooX   ",
+    "XX    XooX  ",
+    "X     XooX  ",
+    "       XooX ",
+    "       XXX  ",
+};
+
+#define ARROW_W 12
+#define ARROW_H 19
+#define SHADOW_ARGB 0x50000000
+
+void cursor_init(void) {
+    uint32_t img[(ARROW_W + 1) * (ARROW_H + 1)];
+    int w = ARROW_W + 1;
+    int h = ARROW_H + 1;
+
+    for (int i = 0; i < w * h; i++) img[i] = 0;
+    for (int y = 0; y < ARROW_H; y++) {
+        for (int x = 0; x < ARROW_W; x++) {
+            char c = arrow_map[y][x];
+            if (c == ' ') continue;
+            // Shadow one pixel down-right, under anything opaque
+            if (!img[(y + 1) * w + x + 1]) img[(y + 1) * w + x + 1] = SHADOW_ARGB;
+            img[y * w + x] = (c == 'X') ? 0xFF000000 : 0xFFFFFFFF;
+        }
+    }
+    cursor_set_image(img, w, h, 0, 0);
+}
+
+int cursor_set_image(const uint32_t* argb, int w, int h, int hx, int hy) {
+    if (w <= 0 || h <= 0 || w > CURSOR_MAX_W || h > CURSOR_MAX_H) return 0;
+    if (hx < 0) hx = 0;
+    if (hy < 0) hy = 0;
+    if (hx >= w) hx = w - 1;
+    if (hy >= h) hy = h - 1;
+    cursor_hide();
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) sprite[y * CURSOR_MAX_W + x] = argb[y * w + x];
+    }
+    sprite_w = w;
+    sprite_h = h;
+    hot_x = hx;
+    hot_y = hy;
+    return 1;
+}
+
+// Only used in direct mode, which implies a 32bpp framebuffer
+static inline uint32_t* page_row(uint32_t* page, int y) {
+    return (uint32_t*)((uint8_t*)page + y * fb_pitch);
+}
+
+// Blend the sprite, sitting at (sx, sy), into a w-wide buffer whose
+// top-left is screen pixel (x0, y0) and which covers rows [y0, y1)
+static void blend_sprite(uint32_t* buf, int x0, int y0, int w, int y1, int sx, int sy) {
+    for (int y = 0; y < sprite_h; y++) {
+        int py = sy + y;
+        if (py < y0 || py >= y1) continue;
+        for (int x = 0; x < sprite_w; x++) {
+            int px = sx + x;
+            if (px < x0 || px >= x0 + w) continue;
+
+            uint32_t s = sprite[y * CURSOR_MAX_W + x];
+            uint8_t a = s >> 24;
+            if (a == 0) continue;
+            uint32_t* d = buf + (py - y0) * w + (px - x0);
+            *d = (a == 255) ? (s & 0x00FFFFFF) : blend_pixel(*d, s, a);
+        }
+    }
+}
+
+// Rebuild (x, y, w, h) of VRAM from the backbuffer plus the sprite
+static void compose(int x, int y, int w, int h) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > (int)scr_width) w = scr_width - x;
+    if (y + h > (int)scr_height) h = scr_height - y;
+    if (w <= 0 || h <= 0) return;
+
+    for (int row = 0; row < h; row++) {
+        gfx_copy_span(scratch + row * w, gfx_row(y + row) + x, w);
+    }
+    blend_sprite(scratch, x, y, w, y + h, cur_x, cur_y);
+    for (int row = 0; row < h; row++) {
+        uint8_t* dst = (uint8_t*)fb + (y + row) * fb_pitch + x * fb_format->bytes_pp;
+        fb_format->store_span(dst, scratch + row * w, w);
+    }
+}
+
+// --- Direct mode: save-under in the displayed buffer ---
+static void under_swap(SaveUnder* s, int save) {
+    for (int y = 0; y < sprite_h; y++) {
+        int py = s->y + y;
+        if (py < 0 || py >= (int)scr_height) continue;
+        uint32_t* row = page_row(s->page, py);
+        for (int x = 0; x < sprite_w; x++) {
+            int px = s->x + x;
+            if (px < 0 || px >= (int)scr_width) continue;
+            if (save) s->pixels[y * CURSOR_MAX_W + x] = row[px];
+            else row[px] = s->pixels[y * CURSOR_MAX_W + x];
+        }
+    }
+}
+
+static void save_restore(SaveUnder* s) {
+    if (!s->drawn) return;
+    under_swap(s, 0);
+    s->drawn = 0;
+}
+
+static void save_draw(SaveUnder* s, uint32_t* page, int nx, int ny) {
+    s->page = page;
+    s->x = nx;
+    s->y = ny;
+    under_swap(s, 1);
+    for (int row = 0; row < sprite_h; row++) {
+        int py = ny + row;
+        if (py < 0 || py >= (int)scr_height) continue;
+        int x0 = nx < 0 ? 0 : nx;
+        int x1 = (nx + sprite_w > (int)scr_width) ? (int)scr_width : nx + sprite_w;
+        if (x0 < x1) blend_sprite(page_row(page, py) + x0, x0, py, x1 - x0, py + 1, nx, ny);
+    }
+    s->drawn = 1;
+}
+
+static inline int is_direct(void) {
+    return direct || backbuffer == fb;
+}
+
+void cursor_hide(void) {
+    if (!drawn || !is_direct()) return;
+    save_restore(&saves[front_save]);
+    drawn = 0;
+}
+
+void cursor_set_direct(int on) {
+    cursor_hide();
+    direct = on;
+    drawn = 0;
+}
+
+void cursor_flip_prepare(uint32_t* next_page) {
+    if (!drawn || sprite_w == 0) return;
+    save_draw(&saves[front_save ^ 1], next_page, cur_x, cur_y);
+}
+
+void cursor_flip_done(void) {
+    if (!drawn) return;
+    save_restore(&saves[front_save]);
+    front_save ^= 1;
+}
+
+void cursor_move(int x, int y) {
+    if (!fb || !backbuffer || sprite_w == 0) return;
+
+    int nx = x - hot_x;
+    int ny = y - hot_y;
+
+    if (is_direct()) {
+        // Already there; redrawing would only make it flicker
+        if (drawn && nx == cur_x && ny == cur_y && saves[front_save].page == fb) return;
+        cursor_hide();
+        cur_x = nx;
+        cur_y = ny;
+        save_draw(&saves[front_save], fb, nx, ny);
+        drawn = 1;
+        return;
+    }
+
+    int ox = cur_x, oy = cur_y;
+    int was_drawn = drawn;
+    cur_x = nx;
+    cur_y = ny;
+    drawn = 1;
+
+    if (!was_drawn) {
+        compose(nx, ny, sprite_w, sprite_h);
+        return;
+    }
+
+    // Nearby positions go out as one rect so the sprite never flickers
+    int ux0 = ox < nx ? ox : nx;
+    int uy0 = oy < ny ? oy : ny;
+    int ux1 = (ox > nx ? ox : nx) + sprite_w;
+    int uy1 = (oy > ny ? oy : ny) + sprite_h;
+    if (ux1 - ux0 <= CURSOR_MAX_W * 2 && uy1 - uy0 <= CURSOR_MAX_H * 2) {
+        compose(ux0, uy0, ux1 - ux0, uy1 - uy0);
+    } else {
+        compose(ox, oy, sprite_w, sprite_h);
+        compose(nx, ny, sprite_w, sprite_h);
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef GFX_CURSOR_H
+#define GFX_CURSOR_H
+
+#include <stdint.h>
+
+// Largest sprite; the sprite, save-under and compose buffers are static
+// and sized from these
+#define CURSOR_MAX_W 32
+#define CURSOR_MAX_H 32
+
+// --- Sprite Cursor ---
+// The cursor never lives in the backbuffer. Each move composites the
+// sprite over the backbuffer pixels around it into a small scratch buffer
+// and writes only that rect to VRAM, so nothing is ever read back from
+// the framebuffer.
+
+// Load the default arrow.
+void cursor_init(void);
+
+// ARGB image, straight alpha, w pixels per row. (hot_x, hot_y) is the
+// pixel that sits on the mouse position and is clamped into the image.
+// Returns 0 and keeps the current sprite if the image is empty or larger
+// than CURSOR_MAX_W x CURSOR_MAX_H.
+int cursor_set_image(const uint32_t* argb, int w, int h, int hot_x, int hot_y);
+
+// Show the cursor at mouse position (x, y), repairing the rect it left.
+// Call it after presenting too, since a present overwrites the sprite.
+void cursor_move(int x, int y);
+
+// Take the cursor off screen before the backbuffer is redrawn. Only does
+// work in direct mode, where the sprite sits in the displayed buffer.
+void cursor_hide(void);
+
+// Page flipping, around the switch to next_page: prepare copies the
+// sprite onto next_page, then done (after the page is shown) takes it
+// off the old one, so the pointer never leaves the screen.
+void cursor_flip_prepare(uint32_t* next_page);
+void cursor_flip_done(void);
+
+// Direct mode: draw into fb with a save-under instead of compositing from
+// the backbuffer. Used when the backbuffer isn't a copy of what's shown
+// (page flipping) or when there is no backbuffer at all. Set it before
+// the first frame.
+void cursor_set_direct(int direct);
+
+#endif
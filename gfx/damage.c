@@ -0,0 +1,112 @@
+#include "damage.h"
+#include "span.h"
+
+DamageList damage;
+
+static int rect_area(const GfxRect* r) {
+    return r->w * r->h;
+}
+
+static GfxRect rect_union(const GfxRect* a, const GfxRect* b) {
+    int x0 = a->x < b->x ? a->x : b->x;
+    int y0 = a->y < b->y ? a->y : b->y;
+    int x1 = (a->x + a->w > b->x + b->w) ? a->x + a->w : b->x + b->w;
+    int y1 = (a->y + a->h > b->y + b->h) ? a->y + a->h : b->y + b->h;
+    GfxRect u = {x0, y0, x1 - x0, y1 - y0};
+    return u;
+}
+
+static int rect_contains(const GfxRect* outer, const GfxRect* inner) {
+    return inner->x >= outer->x && inner->y >= outer->y &&
+           inner->x + inner->w <= outer->x + outer->w &&
+           inner->y + inner->h <= outer->y + outer->h;
+}
+
+int rect_intersects(const GfxRect* a, int x, int y, int w, int h) {
+    return x < a->x + a->w && a->x < x + w &&
+           y < a->y + a->h && a->y < y + h;
+}
+
+// Merging is worth it when the union wastes little area over the two parts
+static int worth_merging(const GfxRect* a, const GfxRect* b) {
+    GfxRect u = rect_union(a, b);
+    return rect_area(&u) * 3 <= (rect_area(a) + rect_area(b)) * 4;
+}
+
+static void remove_rect(int i) {
+    damage.rects[i] = damage.rects[--damage.count];
+}
+
+void damage_add(int x, int y, int w, int h) {
+    if (damage.full) return;
+
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > (int)scr_width) w = (int)scr_width - x;
+    if (y + h > (int)scr_height) h = (int)scr_height - y;
+    if (w <= 0 || h <= 0) return;
+
+    GfxRect r = {x, y, w, h};
+
+    // Fold r into every rect it overlaps or sits next to cheaply; a merge
+    // can make r touch rects it missed before, so rescan after each one.
+    int merged = 1;
+    while (merged) {
+        merged = 0;
+        for (int i = 0; i < damage.count; i++) {
+            GfxRect* cur = &damage.rects[i];
+            if (rect_contains(cur, &r)) return;
+            if (rect_contains(&r, cur) || worth_merging(cur, &r)) {
+                r = rect_union(cur, &r);
+                remove_rect(i);
+                merged = 1;
+                break;
+            }
+        }
+    }
+
+    if (damage.count == DAMAGE_MAX_RECTS) {
+        // List is full: grow whichever rect absorbs r most cheaply
+        int best = 0;
+        int best_cost = 0x7FFFFFFF;
+        for (int i = 0; i < damage.count; i++) {
+            GfxRect u = rect_union(&damage.rects[i], &r);
+            int cost = rect_area(&u) - rect_area(&damage.rects[i]);
+            if (cost < best_cost) { best_cost = cost; best = i; }
+        }
+        r = rect_union(&damage.rects[best], &r);
+        remove_rect(best);
+    }
+
+    damage.rects[damage.count++] = r;
+
+    // Past half the screen, one full pass is cheaper than many partial ones
+    int total = 0;
+    for (int i = 0; i < damage.count; i++) total += rect_area(&damage.rects[i]);
+    if (total * 2 > (int)(scr_width * scr_height)) damage_add_full();
+}
+
+void damage_add_full(void) {
+    damage.full = 1;
+    damage.count = 1;
+    damage.rects[0].x = 0;
+    damage.rects[0].y = 0;
+    damage.rects[0].w = (int)scr_width;
+    damage.rects[0].h = (int)scr_height;
+}
+
+void damage_clear(void) {
+    damage.full = 0;
+    damage.count = 0;
+}
+
+void damage_merge(const DamageList* other) {
+    if (other->full) {
+        damage_add_full();
+        return;
+    }
+    for (int i = 0; i < other->count && !damage.full; i++) {
+        const GfxRect* r = &other->rects[i];
+        damage_add(r->x, r->y, r->w, r->h);
+    }
+}
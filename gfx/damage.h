@@ -0,0 +1,36 @@
+#ifndef GFX_DAMAGE_H
+#define GFX_DAMAGE_H
+
+#include <stdint.h>
+
+typedef struct {
+    int x, y, w, h;
+} GfxRect;
+
+#define DAMAGE_MAX_RECTS 16
+
+typedef struct {
+    GfxRect rects[DAMAGE_MAX_RECTS];
+    int count;
+    int full;       // whole screen needs recompositing
+} DamageList;
+
+extern DamageList damage;
+
+// Queue a screen rect for recompositing. Rects are clipped to the screen,
+// folded into overlapping or nearby rects, and collapse to a full-screen
+// redraw once they cover most of the display.
+void damage_add(int x, int y, int w, int h);
+void damage_add_full(void);
+void damage_clear(void);
+
+// Add every rect of an earlier frame's list to the current one
+void damage_merge(const DamageList* other);
+
+static inline int damage_pending(void) {
+    return damage.full || damage.count > 0;
+}
+
+int rect_intersects(const GfxRect* a, int x, int y, int w, int h);
+
+#endif
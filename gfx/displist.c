@@ -0,0 +1,156 @@
+#include "displist.h"
+#include "span.h"
+
+DisplayStats display_stats;
+
+// --- Rect Regions ---
+// A union of rects, not necessarily disjoint. When a cut would need more
+// rects than fit, the rect being cut is either kept whole or dropped,
+// whichever errs towards drawing more.
+typedef struct {
+    GfxRect rects[DISPLAY_MAX_RECTS];
+    int count;
+} Region;
+
+static int rect_empty(const GfxRect* r) {
+    return r->w <= 0 || r->h <= 0;
+}
+
+static int rect_intersect(GfxRect* out, const GfxRect* a, const GfxRect* b) {
+    int x0 = a->x > b->x ? a->x : b->x;
+    int y0 = a->y > b->y ? a->y : b->y;
+    int x1 = (a->x + a->w < b->x + b->w) ? a->x + a->w : b->x + b->w;
+    int y1 = (a->y + a->h < b->y + b->h) ? a->y + a->h : b->y + b->h;
+    if (x0 >= x1 || y0 >= y1) return 0;
+    out->x = x0; out->y = y0;
+    out->w = x1 - x0; out->h = y1 - y0;
+    return 1;
+}
+
+static void region_add(Region* rg, const GfxRect* r) {
+    if (rect_empty(r) || rg->count >= DISPLAY_MAX_RECTS) return;
+    rg->rects[rg->count++] = *r;
+}
+
+// Remove cut from every rect. Each hit rect becomes up to four pieces:
+// full-width bands above and below the cut, and the parts left and right
+// of it. keep_on_overflow picks what happens when they don't fit.
+static void region_subtract(Region* rg, const GfxRect* cut, int keep_on_overflow) {
+    if (rect_empty(cut)) return;
+
+    Region out;
+    out.count = 0;
+    for (int i = 0; i < rg->count; i++) {
+        const GfxRect* r = &rg->rects[i];
+        GfxRect hit;
+        if (!rect_intersect(&hit, r, cut)) {
+            region_add(&out, r);
+            continue;
+        }
+
+        GfxRect parts[4];
+        int n = 0;
+        if (hit.y > r->y) {
+            parts[n++] = (GfxRect){r->x, r->y, r->w, hit.y - r->y};
+        }
+        if (hit.y + hit.h < r->y + r->h) {
+            parts[n++] = (GfxRect){r->x, hit.y + hit.h, r->w, r->y + r->h - (hit.y + hit.h)};
+        }
+        if (hit.x > r->x) {
+            parts[n++] = (GfxRect){r->x, hit.y, hit.x - r->x, hit.h};
+        }
+        if (hit.x + hit.w < r->x + r->w) {
+            parts[n++] = (GfxRect){hit.x + hit.w, hit.y, r->x + r->w - (hit.x + hit.w), hit.h};
+        }
+
+        // Leave room for the rects still to come, which need one slot each
+        if (out.count + n + (rg->count - i - 1) > DISPLAY_MAX_RECTS) {
+            if (keep_on_overflow) region_add(&out, r);
+            continue;
+        }
+        for (int j = 0; j < n; j++) out.rects[out.count++] = parts[j];
+    }
+    *rg = out;
+}
+
+void displist_reset(DisplayList* list) {
+    list->count = 0;
+}
+
+void displist_add(DisplayList* list, DisplayDrawFn draw, void* ctx,
+                  const GfxRect* bounds, const GfxRect* opaque, const GfxRect* backdrop) {
+    if (list->count >= DISPLAY_MAX_ITEMS) return;
+    DisplayItem* it = &list->items[list->count++];
+    GfxRect none = {0, 0, 0, 0};
+    it->draw = draw;
+    it->ctx = ctx;
+    it->bounds = *bounds;
+    it->opaque = opaque ? *opaque : none;
+    it->backdrop = backdrop ? *backdrop : none;
+}
+
+void displist_execute(const DisplayList* list, const GfxRect* clip) {
+    // Front to back: work out where each layer can still be seen.
+    // visible[i] is the clip minus everything opaque above layer i.
+    static Region visible[DISPLAY_MAX_ITEMS];
+    Region covered;
+    covered.count = 0;
+
+    display_stats.area += (uint32_t)clip->w * clip->h;
+
+    for (int i = list->count - 1; i >= 0; i--) {
+        const DisplayItem* it = &list->items[i];
+        Region* vis = &visible[i];
+        vis->count = 0;
+
+        GfxRect area;
+        if (rect_intersect(&area, &it->bounds, clip)) {
+            region_add(vis, &area);
+            for (int c = 0; c < covered.count && vis->count; c++) {
+                region_subtract(vis, &covered.rects[c], 1);
+            }
+        }
+
+        region_add(&covered, &it->opaque);
+        // What this layer reads must still be rendered underneath it, even
+        // where a layer further up hides it
+        region_subtract(&covered, &it->backdrop, 0);
+    }
+
+    // Back to front: paint each layer into what is left of it
+    for (int i = 0; i < list->count; i++) {
+        const DisplayItem* it = &list->items[i];
+        const Region* vis = &visible[i];
+        if (vis->count == 0) {
+            display_stats.culled++;
+            continue;
+        }
+        // A layer that blurs what is below would read its own output back
+        // where two pieces touch, so it is painted once over their bounding
+        // box. The extra area lies under opaque layers that paint later.
+        GfxRect box;
+        int pieces = vis->count;
+        if (it->backdrop.w > 0 && pieces > 1) {
+            box = vis->rects[0];
+            for (int r = 1; r < vis->count; r++) {
+                const GfxRect* vr = &vis->rects[r];
+                int x1 = box.x + box.w, y1 = box.y + box.h;
+                if (vr->x < box.x) box.x = vr->x;
+                if (vr->y < box.y) box.y = vr->y;
+                if (vr->x + vr->w > x1) x1 = vr->x + vr->w;
+                if (vr->y + vr->h > y1) y1 = vr->y + vr->h;
+                box.w = x1 - box.x;
+                box.h = y1 - box.y;
+            }
+            pieces = 1;
+        }
+        for (int r = 0; r < pieces; r++) {
+            const GfxRect* vr = (pieces == vis->count) ? &vis->rects[r] : &box;
+            gfx_clip_set(vr->x, vr->y, vr->w, vr->h);
+            it->draw(it->ctx);
+            display_stats.drawn++;
+            display_stats.pixels += (uint32_t)vr->w * vr->h;
+        }
+    }
+    gfx_clip_reset();
+}
@@ -0,0 +1,52 @@
+#ifndef GFX_DISPLIST_H
+#define GFX_DISPLIST_H
+
+#include <stdint.h>
+#include "damage.h"
+
+// --- Display List ---
+// A frame is recorded as a back-to-front list of layers, each with the
+// rect it may paint, the part of it that is fully opaque, and the rect it
+// reads back from the layers below (a blur). Executing the list against a
+// clip walks it front to back first, so a layer is rasterized only where
+// no opaque layer above hides it. A layer with a backdrop is drawn in one
+// go over the bounding box of what is left, never piece by piece.
+
+#define DISPLAY_MAX_ITEMS 16
+#define DISPLAY_MAX_RECTS 32
+
+typedef void (*DisplayDrawFn)(void* ctx);
+
+typedef struct {
+    DisplayDrawFn draw;
+    void* ctx;
+    GfxRect bounds;     // everything the layer may touch
+    GfxRect opaque;     // hides what is below, w == 0 if nothing
+    GfxRect backdrop;   // read from below before painting, w == 0 if nothing
+} DisplayItem;
+
+typedef struct {
+    DisplayItem items[DISPLAY_MAX_ITEMS];
+    int count;
+} DisplayList;
+
+typedef struct {
+    uint32_t drawn;     // layer draws issued, one per visible rect or box
+    uint32_t culled;    // layers skipped as fully hidden or outside the clip
+    uint32_t pixels;    // area handed to layer draws
+    uint32_t area;      // area of the clips executed
+} DisplayStats;
+
+extern DisplayStats display_stats;
+
+void displist_reset(DisplayList* list);
+
+// Append a layer above the ones already recorded. Pass NULL for opaque
+// or backdrop when the layer has none.
+void displist_add(DisplayList* list, DisplayDrawFn draw, void* ctx,
+                  const GfxRect* bounds, const GfxRect* opaque, const GfxRect* backdrop);
+
+// Rasterize the part of the list inside clip. Leaves gfx_clip reset.
+void displist_execute(const DisplayList* list, const GfxRect* clip);
+
+#endif
@@ -0,0 +1,138 @@
+#include "frame.h"
+#include "displist.h"
+#include "../drivers/timer.h"
+#include "../drivers/input.h"
+
+FrameStats frame_stats;
+int frame_effects_reduced = 0;
+
+static uint32_t interval;   // ticks per frame
+static uint64_t next_frame;
+static uint64_t frame_start;
+static int overrun_run;
+static int recover_run;
+
+static void u32_to_str(uint32_t v, char* out) {
+    char tmp[12];
+    int n = 0;
+    do { tmp[n++] = '0' + (v % 10); v /= 10; } while (v);
+    while (n) *out++ = tmp[--n];
+    *out = 0;
+}
+
+static char* append(char* dst, const char* src) {
+    while (*src) *dst++ = *src++;
+    *dst = 0;
+    return dst;
+}
+
+static char* append_u32(char* dst, uint32_t v) {
+    char num[12];
+    u32_to_str(v, num);
+    return append(dst, num);
+}
+
+void frame_init(void) {
+    // Stays in 32 bits for TSCs up to hundreds of GHz
+    interval = (timer_ticks_per_ms * 10 / FRAME_HZ) * 100;
+    next_frame = timer_now();
+}
+
+int frame_due(void) {
+    uint64_t now = timer_now();
+    if (now < next_frame) return 0;
+
+    // After a stall start counting again from now rather than rendering a
+    // burst of frames to catch up
+    next_frame += interval;
+    if (next_frame <= now) next_frame = now + interval;
+    return 1;
+}
+
+void frame_idle(void) {
+    frame_stats.idle++;
+}
+
+void frame_begin(void) {
+    frame_start = timer_now();
+}
+
+int frame_end(void) {
+    uint32_t cost = (uint32_t)(timer_now() - frame_start);
+    uint32_t us = timer_ticks_to_us(cost);
+
+    frame_stats.frames++;
+    frame_stats.last_us = us;
+    frame_stats.avg_us = frame_stats.frames == 1 ? us : (frame_stats.avg_us * 7 + us) / 8;
+    if (us > frame_stats.worst_us) frame_stats.worst_us = us;
+
+    if (cost > interval) {
+        frame_stats.overruns++;
+        overrun_run++;
+        recover_run = 0;
+    } else {
+        overrun_run = 0;
+        if (cost < interval / 2) recover_run++;
+        else recover_run = 0;
+    }
+
+    if (!frame_effects_reduced && overrun_run >= FRAME_OVERRUN_LIMIT) {
+        frame_effects_reduced = 1;
+        overrun_run = 0;
+        recover_run = 0;
+        return 1;
+    }
+    if (frame_effects_reduced && recover_run >= FRAME_RECOVER_FRAMES) {
+        frame_effects_reduced = 0;
+        recover_run = 0;
+        return 1;
+    }
+    return 0;
+}
+
+void frame_report(bench_print_fn print) {
+    char line[80];
+    char* p = append(line, "Frames: ");
+    p = append_u32(p, frame_stats.frames);
+    p = append(p, " drawn, ");
+    p = append_u32(p, frame_stats.idle);
+    p = append(p, " idle, ");
+    p = append_u32(p, frame_stats.overruns);
+    p = append(p, " over ");
+    p = append_u32(p, 1000000 / FRAME_HZ);
+    p = append(p, " us");
+    print(line);
+
+    p = append(line, "Frame cost: last ");
+    p = append_u32(p, frame_stats.last_us);
+    p = append(p, " us, avg ");
+    p = append_u32(p, frame_stats.avg_us);
+    p = append(p, " us, worst ");
+    p = append_u32(p, frame_stats.worst_us);
+    p = append(p, " us");
+    if (frame_effects_reduced) p = append(p, ", effects off");
+    print(line);
+
+    p = append(line, "CPU idle: ");
+    p = append_u32(p, idle_percent());
+    p = append(p, "% of the last second");
+    print(line);
+
+    // A full ring means events came faster than frames drained them
+    p = append(line, "Input: ");
+    p = append_u32(p, input_dropped);
+    p = append(p, " events dropped");
+    print(line);
+
+    // Pixels handed to layers per damaged pixel; 100% means no overdraw
+    if (display_stats.area) {
+        p = append(line, "Last frame: ");
+        p = append_u32(p, display_stats.pixels / (display_stats.area / 100 + 1));
+        p = append(p, "% coverage, ");
+        p = append_u32(p, display_stats.drawn);
+        p = append(p, " draws, ");
+        p = append_u32(p, display_stats.culled);
+        p = append(p, " layers culled");
+        print(line);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef GFX_FRAME_H
+#define GFX_FRAME_H
+
+#include <stdint.h>
+#include "bench.h"
+
+// --- Frame Scheduler ---
+// Frames start on a fixed interval from the monotonic timer instead of
+// the emulated vblank, so input and network polling keep running between
+// them. An interval with nothing damaged costs nothing.
+
+#define FRAME_HZ 60
+
+// Consecutive overrunning frames before effects are dropped
+#define FRAME_OVERRUN_LIMIT 3
+// Consecutive frames under half the budget before they come back
+#define FRAME_RECOVER_FRAMES 120
+
+typedef struct {
+    uint32_t frames;       // frames rendered
+    uint32_t idle;         // intervals skipped with no damage
+    uint32_t overruns;     // frames that took longer than the interval
+    uint32_t last_us;      // cost of the latest frame
+    uint32_t avg_us;       // running average, 1/8 weight per frame
+    uint32_t worst_us;
+} FrameStats;
+
+extern FrameStats frame_stats;
+
+// Set while frames overrun; blur and soft shadows are skipped
+extern int frame_effects_reduced;
+
+void frame_init(void);
+
+// Non-zero once per interval; the caller then renders or calls frame_idle.
+int frame_due(void);
+
+void frame_idle(void);
+
+// Bracket the render of a due frame. frame_end returns non-zero when the
+// effect level changed and the whole screen needs redrawing.
+void frame_begin(void);
+int frame_end(void);
+
+// Prints the interval and the render cost statistics
+void frame_report(bench_print_fn print);
+
+#endif
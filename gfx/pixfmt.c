@@ -0,0 +1,89 @@
+#include "pixfmt.h"
+#include "span.h"
+
+const PixelFormat* fb_format = 0;
+
+// --- Per-format span converters ---
+// PACK turns an XRGB pixel `c` into the framebuffer type T
+#define DEFINE_PIXFMT(fmt, T, PACK)                                          \
+    static void fmt##_store(void* dst, const uint32_t* src, int count) {     \
+        T* d = (T*)dst;                                                      \
+        for (int i = 0; i < count; i++) {                                    \
+            uint32_t c = src[i];                                             \
+            d[i] = (T)(PACK);                                                \
+        }                                                                    \
+    }
+
+DEFINE_PIXFMT(rgb565, uint16_t,
+    ((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F))
+
+DEFINE_PIXFMT(rgb555, uint16_t,
+    ((c >> 9) & 0x7C00) | ((c >> 6) & 0x03E0) | ((c >> 3) & 0x001F))
+
+DEFINE_PIXFMT(xbgr8888, uint32_t,
+    ((c >> 16) & 0xFF) | (c & 0xFF00) | ((c & 0xFF) << 16))
+
+// Packed 24-bit has no matching C type; move three bytes per pixel in
+// memory order, blue first for RGB and red first for BGR
+static void rgb888_store(void* dst, const uint32_t* src, int count) {
+    uint8_t* d = (uint8_t*)dst;
+    for (int i = 0; i < count; i++) {
+        uint32_t c = src[i];
+        d[0] = (uint8_t)c;
+        d[1] = (uint8_t)(c >> 8);
+        d[2] = (uint8_t)(c >> 16);
+        d += 3;
+    }
+}
+
+static void bgr888_store(void* dst, const uint32_t* src, int count) {
+    uint8_t* d = (uint8_t*)dst;
+    for (int i = 0; i < count; i++) {
+        uint32_t c = src[i];
+        d[0] = (uint8_t)(c >> 16);
+        d[1] = (uint8_t)(c >> 8);
+        d[2] = (uint8_t)c;
+        d += 3;
+    }
+}
+
+// Same layout as the backbuffer, a straight copy
+static void xrgb8888_store(void* dst, const uint32_t* src, int count) {
+    gfx_copy_span((uint32_t*)dst, src, count);
+}
+
+// --- Selection ---
+// A format is picked when the mode's bytes per pixel and all three
+// channel positions and sizes match its row
+typedef struct {
+    PixelFormat fmt;
+    uint8_t fields[6];   // red pos, size, green pos, size, blue pos, size
+} FormatLayout;
+
+static const FormatLayout formats[] = {
+    { { "XRGB8888", 4, 1, xrgb8888_store }, { 16, 8, 8, 8,  0, 8 } },
+    { { "XBGR8888", 4, 0, xbgr8888_store }, {  0, 8, 8, 8, 16, 8 } },
+    { { "RGB888",   3, 0, rgb888_store },   { 16, 8, 8, 8,  0, 8 } },
+    { { "BGR888",   3, 0, bgr888_store },   {  0, 8, 8, 8, 16, 8 } },
+    { { "RGB565",   2, 0, rgb565_store },   { 11, 5, 5, 6,  0, 5 } },
+    { { "RGB555",   2, 0, rgb555_store },   { 10, 5, 5, 5,  0, 5 } },
+};
+
+int pixfmt_select(uint8_t bpp, const uint8_t* fields) {
+    fb_format = 0;
+    uint8_t bytes_pp = (bpp + 7) / 8;
+    for (uint32_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        const FormatLayout* f = &formats[i];
+        if (f->fmt.bytes_pp != bytes_pp) continue;
+
+        int same = 1;
+        for (int j = 0; j < 6; j++) {
+            if (f->fields[j] != fields[j]) same = 0;
+        }
+        if (same) {
+            fb_format = &f->fmt;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef GFX_PIXFMT_H
+#define GFX_PIXFMT_H
+
+#include <stdint.h>
+
+// --- Framebuffer Pixel Formats ---
+// Everything draws into a 32bpp XRGB backbuffer; only the spans that
+// cross into VRAM care about the mode GRUB picked. Each format gets its
+// own converters, stamped out by a macro so the per-pixel loops carry no
+// bpp checks, and boot selects one through fb_format.
+
+typedef struct {
+    const char* name;
+    uint8_t bytes_pp;
+    // Pixels sit in VRAM exactly as in the backbuffer, so it can be drawn
+    // into or copied to directly
+    uint8_t native;
+    // XRGB to framebuffer pixels
+    void (*store_span)(void* dst, const uint32_t* src, int count);
+} PixelFormat;
+
+// Format of the displayed framebuffer, NULL until pixfmt_select succeeds
+extern const PixelFormat* fb_format;
+
+// Pick the converters for a direct-colour mode. `fields` is the multiboot
+// color_info: red position and size, then green, then blue. Returns 0 and
+// leaves fb_format NULL for layouts it can't drive.
+int pixfmt_select(uint8_t bpp, const uint8_t* fields);
+
+#endif
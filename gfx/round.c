@@ -0,0 +1,111 @@
+#include "round.h"
+#include "span.h"
+#include "blend.h"
+#include "surface.h"
+
+#define ROUND_CACHE 4
+
+static CornerTable corner_cache[ROUND_CACHE];
+static int corner_next = 0;
+
+// 4x4 supersampled coverage of a circle of radius r + 0.5 centred on
+// pixel (0, 0), which keeps the old hard edge's pixel centres inside
+static void corner_build(CornerTable* t, int r) {
+    static const int sub[4] = {-3, -1, 1, 3};
+    int lim = (8 * r + 4) * (8 * r + 4);
+
+    t->r = r;
+    for (int d = 1; d <= r; d++) {
+        t->edge[d] = r;
+        t->solid[d] = r;
+        for (int j = r - 1; j >= 0; j--) {
+            int e = r - j;
+            int hits = 0;
+            for (int sy = 0; sy < 4; sy++) {
+                int py = d * 8 + sub[sy];
+                for (int sx = 0; sx < 4; sx++) {
+                    int px = e * 8 + sub[sx];
+                    if (px * px + py * py <= lim) hits++;
+                }
+            }
+            t->cov[d][j] = (uint8_t)(hits * 255 / 16);
+            if (hits) t->edge[d] = j;
+            if (hits == 16) t->solid[d] = j;
+        }
+    }
+}
+
+const CornerTable* corner_table(int r) {
+    if (r > ROUND_MAX_R) r = ROUND_MAX_R;
+    for (int i = 0; i < ROUND_CACHE; i++) {
+        if (corner_cache[i].r == r) return &corner_cache[i];
+    }
+
+    CornerTable* t = &corner_cache[corner_next];
+    corner_next = (corner_next + 1) % ROUND_CACHE;
+    corner_build(t, r);
+    return t;
+}
+
+static inline void blend_clipped(int x, int y, uint32_t color, uint8_t alpha) {
+    if (x < gfx_clip.x0 || x >= gfx_clip.x1 || y < gfx_clip.y0 || y >= gfx_clip.y1) return;
+    uint32_t* p = gfx_row(y) + x;
+    *p = blend_pixel(*p, color, alpha);
+}
+
+static inline void span_clipped(int x0, int x1, int y, uint32_t color, uint8_t alpha) {
+    if (x0 < gfx_clip.x0) x0 = gfx_clip.x0;
+    if (x1 > gfx_clip.x1) x1 = gfx_clip.x1;
+    if (x0 >= x1) return;
+
+    uint32_t* row = gfx_row(y);
+    if (alpha == 255) {
+        gfx_fill_span(row + x0, color, x1 - x0);
+    } else {
+        gfx_blend_span(row + x0, x1 - x0, color, alpha);
+    }
+}
+
+void gfx_fill_rounded(int x, int y, int w, int h, int r, uint32_t color, uint8_t alpha) {
+    if (!backbuffer || alpha == 0 || w <= 0 || h <= 0) return;
+
+    // Left and right corners must not overlap. Top corners win over bottom
+    // ones when h < 2r, which the titlebar relies on.
+    if (r > w / 2) r = w / 2;
+    const CornerTable* t = 0;
+    if (r > 0) {
+        t = corner_table(r);
+        r = t->r;
+    } else {
+        r = 0;
+    }
+
+    int row0 = (y < gfx_clip.y0) ? gfx_clip.y0 - y : 0;
+    int row1 = (y + h > gfx_clip.y1) ? gfx_clip.y1 - y : h;
+
+    for (int i = row0; i < row1; i++) {
+        int py = y + i;
+        int d = 0;
+        if (i < r) d = r - i;
+        else if (i >= h - r) d = i - (h - r - 1);
+
+        if (d == 0) {
+            span_clipped(x, x + w, py, color, alpha);
+            continue;
+        }
+
+        int solid = t->solid[d];
+        span_clipped(x + solid, x + w - solid, py, color, alpha);
+
+        // Partly covered pixels are the only per-pixel work left. They
+        // aren't painted into retained surfaces, whose unpainted pixels
+        // let the live frame's anti-aliased edge show through instead.
+        if (surface_active) continue;
+        for (int j = t->edge[d]; j < solid; j++) {
+            uint8_t a = (uint8_t)((alpha * t->cov[d][j] + 127) / 255);
+            if (!a) continue;
+            blend_clipped(x + j, py, color, a);
+            blend_clipped(x + w - 1 - j, py, color, a);
+        }
+    }
+}
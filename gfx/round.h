@@ -0,0 +1,28 @@
+#ifndef GFX_ROUND_H
+#define GFX_ROUND_H
+
+#include <stdint.h>
+
+// Largest corner radius with its own table; bigger radii are clamped
+#define ROUND_MAX_R 32
+
+// Coverage of one quarter-circle corner, built once per radius. d is a
+// corner row's distance from the circle's centre row (r at the straight
+// edge, 1 next to the straight sides); columns count from the outside in.
+// Row d leaves edge[d] pixels uncovered, then has partially covered pixels
+// up to solid[d], after which it is fully covered.
+typedef struct {
+    int r;
+    uint8_t edge[ROUND_MAX_R + 1];
+    uint8_t solid[ROUND_MAX_R + 1];
+    uint8_t cov[ROUND_MAX_R + 1][ROUND_MAX_R];
+} CornerTable;
+
+const CornerTable* corner_table(int r);
+
+// Fill a rect with anti-aliased rounded corners, clipped to gfx_clip.
+// Interiors go through the span fill and blend kernels; only the partly
+// covered corner pixels are blended one at a time.
+void gfx_fill_rounded(int x, int y, int w, int h, int r, uint32_t color, uint8_t alpha);
+
+#endif
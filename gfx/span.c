@@ -0,0 +1,67 @@
+#include "span.h"
+
+GfxClip gfx_clip = {0, 0, 1024, 768};
+
+void gfx_clip_reset(void) {
+    gfx_clip.x0 = 0;
+    gfx_clip.y0 = 0;
+    gfx_clip.x1 = (int)scr_width;
+    gfx_clip.y1 = (int)scr_height;
+}
+
+void gfx_clip_set(int x, int y, int w, int h) {
+    gfx_clip_reset();
+    if (!gfx_clip_rect(&x, &y, &w, &h)) {
+        gfx_clip.x1 = gfx_clip.x0;
+        gfx_clip.y1 = gfx_clip.y0;
+        return;
+    }
+    gfx_clip.x0 = x;
+    gfx_clip.y0 = y;
+    gfx_clip.x1 = x + w;
+    gfx_clip.y1 = y + h;
+}
+
+int gfx_clip_rect(int* x, int* y, int* w, int* h) {
+    int x0 = *x, y0 = *y;
+    int x1 = x0 + *w, y1 = y0 + *h;
+    if (x0 < gfx_clip.x0) x0 = gfx_clip.x0;
+    if (y0 < gfx_clip.y0) y0 = gfx_clip.y0;
+    if (x1 > gfx_clip.x1) x1 = gfx_clip.x1;
+    if (y1 > gfx_clip.y1) y1 = gfx_clip.y1;
+    if (x0 >= x1 || y0 >= y1) return 0;
+    *x = x0; *y = y0;
+    *w = x1 - x0; *h = y1 - y0;
+    return 1;
+}
+
+void gfx_fill_span(uint32_t* dst, uint32_t color, int count) {
+    if (count <= 0) return;
+
+    // rep stosl has a fixed startup cost that dominates very short runs
+    if (count < 16) {
+        while (count >= 4) {
+            dst[0] = color; dst[1] = color; dst[2] = color; dst[3] = color;
+            dst += 4;
+            count -= 4;
+        }
+        while (count--) *dst++ = color;
+        return;
+    }
+
+    asm volatile("rep stosl" : "+D"(dst), "+c"(count) : "a"(color) : "memory");
+}
+
+void gfx_fill_rect(int x, int y, int w, int h, uint32_t color) {
+    if (!backbuffer) return;
+    if (!gfx_clip_rect(&x, &y, &w, &h)) return;
+
+    for (int row = y; row < y + h; row++) {
+        gfx_fill_span(gfx_row(row) + x, color, w);
+    }
+}
+
+void gfx_copy_span(uint32_t* dst, const uint32_t* src, int count) {
+    if (count <= 0) return;
+    asm volatile("rep movsl" : "+D"(dst), "+S"(src), "+c"(count) : : "memory");
+}
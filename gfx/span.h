@@ -0,0 +1,42 @@
+#ifndef GFX_SPAN_H
+#define GFX_SPAN_H
+
+#include <stdint.h>
+
+// --- Framebuffer State (defined in kernel.c) ---
+extern uint32_t* fb;
+extern uint32_t* backbuffer;
+extern uint32_t scr_width;
+extern uint32_t scr_height;
+extern uint32_t pitch;      // backbuffer stride; pixels are always 32bpp
+extern uint32_t fb_pitch;   // framebuffer stride, see pixfmt.h
+extern uint8_t bpp;
+
+// --- Clip Rectangle ---
+// Half-open box [x0, x1) x [y0, y1) that every primitive clips against.
+// It never extends past the screen, except while a retained surface is
+// the render target (see surface.h).
+typedef struct {
+    int x0, y0, x1, y1;
+} GfxClip;
+
+extern GfxClip gfx_clip;
+
+void gfx_clip_reset(void);
+void gfx_clip_set(int x, int y, int w, int h);
+
+// Clip a rect against gfx_clip in place. Returns 0 if nothing is left.
+int gfx_clip_rect(int* x, int* y, int* w, int* h);
+
+static inline uint32_t* gfx_row(int y) {
+    return (uint32_t*)((uint8_t*)backbuffer + y * pitch);
+}
+
+// --- Span Fill ---
+void gfx_fill_span(uint32_t* dst, uint32_t color, int count);
+void gfx_fill_rect(int x, int y, int w, int h, uint32_t color);
+
+// --- Span Copy ---
+void gfx_copy_span(uint32_t* dst, const uint32_t* src, int count);
+
+#endif
@@ -0,0 +1,93 @@
+#include "surface.h"
+#include "span.h"
+
+static uint32_t arena_next = 0;
+static uint32_t arena_end = 0;
+
+int surface_active = 0;
+
+static uint32_t* saved_backbuffer;
+static uint32_t saved_pitch;
+static GfxClip saved_clip;
+
+void surface_arena_init(uint32_t start, uint32_t end) {
+    arena_next = (start + 0xFFF) & ~0xFFF;
+    arena_end = end;
+}
+
+uint32_t* surface_alloc(uint32_t pixels) {
+    uint32_t bytes = (pixels * 4 + 0xFFF) & ~0xFFF;
+    if (!arena_next || arena_next + bytes > arena_end || arena_next + bytes < arena_next) return 0;
+
+    uint32_t* p = (uint32_t*)arena_next;
+    arena_next += bytes;
+    return p;
+}
+
+static void redirect(uint32_t* pixels, int x, int y, int w, int h) {
+    saved_backbuffer = backbuffer;
+    saved_pitch = pitch;
+    saved_clip = gfx_clip;
+
+    // Bias the base pointer so screen coordinates inside the surface rect
+    // land on surface pixels; nothing outside the clip is ever touched
+    pitch = (uint32_t)w * 4;
+    backbuffer = (uint32_t*)((uint8_t*)pixels - (uint32_t)y * pitch - (uint32_t)x * 4);
+    gfx_clip.x0 = x;
+    gfx_clip.y0 = y;
+    gfx_clip.x1 = x + w;
+    gfx_clip.y1 = y + h;
+    surface_active = 1;
+}
+
+void surface_begin(uint32_t* pixels, int x, int y, int w, int h) {
+    redirect(pixels, x, y, w, h);
+    gfx_fill_span(pixels, SURFACE_KEY, w * h);
+}
+
+void surface_begin_rect(uint32_t* pixels, int x, int y, int w, int h,
+                        int rx, int ry, int rw, int rh) {
+    redirect(pixels, x, y, w, h);
+
+    // Narrow the clip to the rect and clear just that
+    if (!gfx_clip_rect(&rx, &ry, &rw, &rh)) {
+        gfx_clip.x1 = gfx_clip.x0;
+        gfx_clip.y1 = gfx_clip.y0;
+        return;
+    }
+    gfx_clip.x0 = rx;
+    gfx_clip.y0 = ry;
+    gfx_clip.x1 = rx + rw;
+    gfx_clip.y1 = ry + rh;
+    for (int row = ry; row < ry + rh; row++) {
+        gfx_fill_span(gfx_row(row) + rx, SURFACE_KEY, rw);
+    }
+}
+
+void surface_end(void) {
+    backbuffer = saved_backbuffer;
+    pitch = saved_pitch;
+    gfx_clip = saved_clip;
+    surface_active = 0;
+}
+
+void surface_blit(const uint32_t* pixels, int x, int y, int w, int h) {
+    if (!backbuffer) return;
+
+    int cx = x, cy = y, cw = w, ch = h;
+    if (!gfx_clip_rect(&cx, &cy, &cw, &ch)) return;
+
+    for (int row = cy; row < cy + ch; row++) {
+        const uint32_t* src = pixels + (row - y) * w + (cx - x);
+        uint32_t* dst = gfx_row(row) + cx;
+
+        // Copy each run of painted pixels in one go
+        int i = 0;
+        while (i < cw) {
+            while (i < cw && (src[i] & SURFACE_KEY)) i++;
+            int start = i;
+            while (i < cw && !(src[i] & SURFACE_KEY)) i++;
+            if (i > start) gfx_copy_span(dst + start, src + start, i - start);
+        }
+    }
+}
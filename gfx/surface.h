@@ -0,0 +1,34 @@
+#ifndef GFX_SURFACE_H
+#define GFX_SURFACE_H
+
+#include <stdint.h>
+
+// --- Retained Surfaces ---
+// Off-screen 32bpp pixel buffers that windows paint into once and the
+// compositor blits from on every frame they're visible.
+
+// Pixels that were never painted keep this value and are skipped by
+// surface_blit. Drawing never sets the top byte, so it can't collide.
+#define SURFACE_KEY 0xFF000000
+
+// Carve surfaces out of [start, end). Returns NULL once the arena is spent.
+void surface_arena_init(uint32_t start, uint32_t end);
+uint32_t* surface_alloc(uint32_t pixels);
+
+// Redirect all drawing into a w x h surface that sits at screen position
+// (x, y). Primitives keep taking screen coordinates; the clip becomes the
+// surface bounds. The surface starts out fully transparent.
+void surface_begin(uint32_t* pixels, int x, int y, int w, int h);
+// Same, but only the screen rect (rx, ry, rw, rh) is cleared and drawable;
+// the rest of the surface keeps its pixels
+void surface_begin_rect(uint32_t* pixels, int x, int y, int w, int h,
+                        int rx, int ry, int rw, int rh);
+void surface_end(void);
+
+extern int surface_active;
+
+// Copy the painted pixels of a surface to (x, y) in the backbuffer,
+// honouring gfx_clip.
+void surface_blit(const uint32_t* pixels, int x, int y, int w, int h);
+
+#endif
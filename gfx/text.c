@@ -0,0 +1,51 @@
+#include "text.h"
+#include "span.h"
+#include "../font.h"
+
+// --- Glyph Row Masks ---
+// glyph_row_mask[b][i] is all ones when pixel i of a glyph row byte b is
+// set (bit 7 is the leftmost pixel), so a row is drawn without bit tests.
+#define GM(b, i) ((((b) >> (7 - (i))) & 1) ? 0xFFFFFFFFu : 0u)
+#define GROW(b) {GM(b, 0), GM(b, 1), GM(b, 2), GM(b, 3), GM(b, 4), GM(b, 5), GM(b, 6), GM(b, 7)}
+#define GROW4(b) GROW(b), GROW((b) + 1), GROW((b) + 2), GROW((b) + 3)
+#define GROW16(b) GROW4(b), GROW4((b) + 4), GROW4((b) + 8), GROW4((b) + 12)
+#define GROW64(b) GROW16(b), GROW16((b) + 16), GROW16((b) + 32), GROW16((b) + 48)
+
+static const uint32_t glyph_row_mask[256][8] = {
+    GROW64(0), GROW64(64), GROW64(128), GROW64(192)
+};
+
+static const uint8_t blank_glyph[8] = {0};
+
+void draw_text_run(const char* str, int len, int x, int y, uint32_t fg) {
+    if (!backbuffer || !str) return;
+    if (len < 0) {
+        len = 0;
+        while (str[len]) len++;
+    }
+
+    int cx = x, cy = y, cw = len * 8, ch = 8;
+    if (!gfx_clip_rect(&cx, &cy, &cw, &ch)) return;
+
+    int first = (cx - x) / 8;
+    int last = (cx + cw - 1 - x) / 8;
+    int r0 = cy - y;
+    int r1 = r0 + ch;
+
+    for (int i = first; i <= last; i++) {
+        int gx = x + i * 8;
+        int c0 = (cx > gx) ? cx - gx : 0;
+        int c1 = (cx + cw < gx + 8) ? cx + cw - gx : 8;
+
+        // Characters outside the font still take up a cell
+        unsigned char c = (unsigned char)str[i];
+        const uint8_t* glyph = (c < 128) ? font8x8[c] : blank_glyph;
+
+        for (int r = r0; r < r1; r++) {
+            if (!glyph[r]) continue;
+            uint32_t* dst = gfx_row(y + r) + gx;
+            const uint32_t* m = glyph_row_mask[glyph[r]];
+            for (int k = c0; k < c1; k++) dst[k] = (dst[k] & ~m[k]) | (fg & m[k]);
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef GFX_TEXT_H
+#define GFX_TEXT_H
+
+#include <stdint.h>
+
+// Draw len characters of str (or up to the NUL when len < 0) in the 8x8
+// font at (x, y). The run is clipped against gfx_clip once, then each
+// glyph row is written with masked stores; pixels between the strokes
+// are left untouched.
+void draw_text_run(const char* str, int len, int x, int y, uint32_t fg);
+
+#endif
@@ -0,0 +1,162 @@
+#include "wallpaper.h"
+#include "span.h"
+#include "surface.h"
+#include "blur.h"
+#include "../drivers/smp.h"
+#include "../mm/pmm.h"
+
+// Resampling is cut into this many row bands for the CPUs to share
+#define WALLPAPER_BANDS 32
+
+// Screen placement of the scaled image. cache holds it when there was
+// memory for it; otherwise rows are resampled from the module as drawn.
+static int loaded = 0;
+static uint32_t* cache = 0;
+static int cache_x, cache_y, cache_w, cache_h;
+
+static uint32_t* blurred = 0;
+static int blurred_valid = 0;
+static uint32_t blurred_bg;
+
+// The image being decoded, shared by the band jobs
+static struct {
+    const uint8_t* pixels;
+    int w, h, bytes_pp, bottom_up;
+    uint32_t row_stride;
+} src;
+
+typedef struct {
+    int y0, y1;
+} Band;
+
+// Nearest-neighbour resample of `count` pixels of scaled row y, starting
+// at column x0, BGR(A) to XRGB
+static void resample_span(uint32_t* dst, int y, int x0, int count) {
+    int sy = (int)((uint32_t)y * src.h / cache_h);
+    if (src.bottom_up) sy = src.h - 1 - sy;
+    const uint8_t* row = src.pixels + sy * src.row_stride;
+    for (int x = 0; x < count; x++) {
+        const uint8_t* p = row + ((uint32_t)(x0 + x) * src.w / cache_w) * src.bytes_pp;
+        dst[x] = ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+    }
+}
+
+static void resample_rows(void* arg) {
+    Band* b = (Band*)arg;
+    for (int y = b->y0; y < b->y1; y++) resample_span(cache + y * cache_w, y, 0, cache_w);
+}
+
+int wallpaper_load(const void* bmp) {
+    const uint8_t* bmp8 = (const uint8_t*)bmp;
+    if (!bmp8 || bmp8[0] != 'B' || bmp8[1] != 'M') return 0;
+
+    uint32_t offset = *(const uint32_t*)&bmp8[10];
+    int w = *(const int32_t*)&bmp8[18];
+    int h = *(const int32_t*)&bmp8[22];
+    uint16_t bpp_img = *(const uint16_t*)&bmp8[28];
+    if (bpp_img != 24 && bpp_img != 32) return 0;
+
+    // Positive height means rows are stored bottom-up
+    int bottom_up = 1;
+    if (h < 0) { h = -h; bottom_up = 0; }
+    if (w <= 0 || h <= 0) return 0;
+
+    // Fit inside the screen without distorting the picture
+    int sw = (int)scr_width;
+    int sh = (int)scr_height;
+    int dw, dh;
+    if ((uint32_t)w * sh <= (uint32_t)h * sw) {
+        dh = sh;
+        dw = (int)((uint32_t)w * sh / h);
+    } else {
+        dw = sw;
+        dh = (int)((uint32_t)h * sw / w);
+    }
+    if (dw < 1) dw = 1;
+    if (dh < 1) dh = 1;
+
+    cache_w = dw;
+    cache_h = dh;
+    cache_x = (sw - dw) / 2;
+    cache_y = (sh - dh) / 2;
+
+    src.pixels = bmp8 + offset;
+    src.w = w;
+    src.h = h;
+    src.bytes_pp = bpp_img / 8;
+    src.bottom_up = bottom_up;
+    src.row_stride = ((uint32_t)w * src.bytes_pp + 3) & ~3;
+    loaded = 1;
+
+    // Without the surface arena (no RAM backbuffer) try the page
+    // allocator; failing that too, draws resample from the module
+    cache = surface_alloc((uint32_t)dw * dh);
+    if (!cache) cache = (uint32_t*)pmm_alloc((uint32_t)dw * dh * 4);
+    if (!cache) return 1;
+
+    static Band bands[WALLPAPER_BANDS];
+    SmpGroup group = { 0 };
+    int rows = (dh + WALLPAPER_BANDS - 1) / WALLPAPER_BANDS;
+    for (int i = 0; i < WALLPAPER_BANDS && i * rows < dh; i++) {
+        bands[i].y0 = i * rows;
+        bands[i].y1 = (i + 1) * rows < dh ? (i + 1) * rows : dh;
+        smp_submit(&group, resample_rows, &bands[i]);
+    }
+    smp_wait(&group);
+    return 1;
+}
+
+int wallpaper_draw(uint32_t bg) {
+    if (!loaded || !backbuffer) return 0;
+
+    // Letterbox bars around the image
+    if (cache_w < (int)scr_width || cache_h < (int)scr_height) {
+        gfx_fill_rect(0, 0, scr_width, cache_y, bg);
+        gfx_fill_rect(0, cache_y + cache_h, scr_width, scr_height - cache_y - cache_h, bg);
+        gfx_fill_rect(0, cache_y, cache_x, cache_h, bg);
+        gfx_fill_rect(cache_x + cache_w, cache_y, scr_width - cache_x - cache_w, cache_h, bg);
+    }
+
+    int x = cache_x, y = cache_y, w = cache_w, h = cache_h;
+    if (!gfx_clip_rect(&x, &y, &w, &h)) return 1;
+
+    for (int row = y; row < y + h; row++) {
+        if (cache) {
+            gfx_copy_span(gfx_row(row) + x, cache + (row - cache_y) * cache_w + (x - cache_x), w);
+        } else {
+            resample_span(gfx_row(row) + x, row - cache_y, x - cache_x, w);
+        }
+    }
+    return 1;
+}
+
+int wallpaper_draw_blurred(int x, int y, int w, int h, uint32_t bg) {
+    if (!backbuffer || surface_active) return 0;
+
+    // A flat colour blurs to itself
+    if (!loaded) {
+        gfx_fill_rect(x, y, w, h, bg);
+        return 1;
+    }
+
+    int sw = (int)scr_width;
+    int sh = (int)scr_height;
+    if (!blurred) {
+        blurred = surface_alloc((uint32_t)sw * sh);
+        if (!blurred) return 0;
+    }
+    if (!blurred_valid || blurred_bg != bg) {
+        surface_begin(blurred, 0, 0, sw, sh);
+        wallpaper_draw(bg);
+        gfx_blur_rect(0, 0, sw, sh, BLUR_RADIUS);
+        surface_end();
+        blurred_valid = 1;
+        blurred_bg = bg;
+    }
+
+    if (!gfx_clip_rect(&x, &y, &w, &h)) return 1;
+    for (int row = y; row < y + h; row++) {
+        gfx_copy_span(gfx_row(row) + x, blurred + row * sw + x, w);
+    }
+    return 1;
+}
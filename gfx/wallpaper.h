@@ -0,0 +1,25 @@
+#ifndef GFX_WALLPAPER_H
+#define GFX_WALLPAPER_H
+
+#include <stdint.h>
+
+// --- Wallpaper Cache ---
+// The BMP module is decoded once into screen pixels, scaled to fit the
+// display with its aspect ratio kept and centred. Redraws are row copies.
+// When there is no memory for the cache, each draw resamples the visible
+// rows from the module instead.
+
+// Decode a 24/32bpp BMP. Returns 0 if the image is unusable;
+// wallpaper_draw then reports nothing drawn.
+int wallpaper_load(const void* bmp);
+
+// Draw the cached image inside gfx_clip, filling any letterbox bars with
+// bg. Returns 0 if no wallpaper is loaded.
+int wallpaper_draw(uint32_t bg);
+
+// Draw the wallpaper as it looks after gfx_blur_rect(BLUR_RADIUS) inside
+// (x, y, w, h) and gfx_clip. The blurred layer is built on first use and
+// rebuilt when bg changes. Returns 0 if it couldn't be cached.
+int wallpaper_draw_blurred(int x, int y, int w, int h, uint32_t bg);
+
+#endif
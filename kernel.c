@@ -1,10 +1,33 @@
 #include <stdint.h>
 #include <stddef.h>
-#include "font.h"
 #include "apps/apps.h"
 #include "drivers/ahci.h"
 #include "drivers/pci.h"
 #include "drivers/net.h"
+#include "drivers/cpu.h"
+#include "drivers/timer.h"
+#include "drivers/pic.h"
+#include "drivers/input.h"
+#include "mm/pmm.h"
+#include "mm/paging.h"
+#include "drivers/mtrr.h"
+#include "drivers/bga.h"
+#include "drivers/serial.h"
+#include "drivers/smp.h"
+#include "gfx/span.h"
+#include "gfx/blend.h"
+#include "gfx/damage.h"
+#include "gfx/surface.h"
+#include "gfx/wallpaper.h"
+#include "gfx/text.h"
+#include "gfx/blur.h"
+#include "gfx/round.h"
+#include "gfx/cursor.h"
+#include "gfx/bench.h"
+#include "gfx/frame.h"
+#include "gfx/pixfmt.h"
+#include "gfx/displist.h"
+#include "gfx/chrome.h"
 
 
 // ===== Forward Declarations =====
@@ -73,18 +96,18 @@ void* wallpaper_ptr = NULL;
 
 // --- VESA Graphics ---
 
-uint32_t cursor_backup[8 * 8];
 uint32_t* fb = NULL;          
 uint32_t* backbuffer = NULL;  
 uint32_t scr_width = 1024;
 uint32_t scr_height = 768;
-uint32_t pitch = 0;
-uint8_t bpp = 32;
+uint32_t pitch = 0;      // backbuffer row stride, always 32bpp
+uint32_t fb_pitch = 0;   // framebuffer row stride in its own format
+uint8_t bpp = 32;        // framebuffer depth
 
 
 void draw_pixel(int x, int y, uint32_t color) {
-    if (x < 0 || x >= (int)scr_width || y < 0 || y >= (int)scr_height || !backbuffer) return;
-    uint32_t offset = (y * pitch) + (x * (bpp / 8));
+    if (x < gfx_clip.x0 || x >= gfx_clip.x1 || y < gfx_clip.y0 || y >= gfx_clip.y1 || !backbuffer) return;
+    uint32_t offset = (y * pitch) + (x * 4);
     *(uint32_t*)((uint8_t*)backbuffer + offset) = color;
 }
 
@@ -95,11 +118,7 @@ uint32_t get_pixel(int x, int y) {
 }
 
 void draw_rect(int x, int y, int w, int h, uint32_t color) {
-    for (int i = 0; i < h; i++) {
-        for (int j = 0; j < w; j++) {
-            draw_pixel(x + j, y + i, color);
-        }
-    }
+    gfx_fill_rect(x, y, w, h, color);
 }
 
 int detect_acpi() {
@@ -119,180 +138,66 @@ int detect_acpi() {
 
 void draw_rect_alpha(int x, int y, int w, int h, uint32_t color, uint8_t alpha) {
     if (alpha == 255) { draw_rect(x, y, w, h, color); return; }
-    if (alpha == 0) return;
-    
-    uint32_t src_r = (color >> 16) & 0xFF;
-    uint32_t src_g = (color >> 8) & 0xFF;
-    uint32_t src_b = color & 0xFF;
-    
-    for (int i = 0; i < h; i++) {
-        for (int j = 0; j < w; j++) {
-            int px = x + j;
-            int py = y + i;
-            if (px < 0 || px >= (int)scr_width || py < 0 || py >= (int)scr_height) continue;
-            
-            uint32_t dest_col = get_pixel(px, py);
-            uint32_t dest_r = (dest_col >> 16) & 0xFF;
-            uint32_t dest_g = (dest_col >> 8) & 0xFF;
-            uint32_t dest_b = dest_col & 0xFF;
-            
-            uint32_t res_r = (src_r * alpha + dest_r * (255 - alpha)) >> 8;
-            uint32_t res_g = (src_g * alpha + dest_g * (255 - alpha)) >> 8;
-            uint32_t res_b = (src_b * alpha + dest_b * (255 - alpha)) >> 8;
-            
-            draw_pixel(px, py, (res_r << 16) | (res_g << 8) | res_b);
-        }
+    if (alpha == 0 || !backbuffer) return;
+    if (!gfx_clip_rect(&x, &y, &w, &h)) return;
+
+    for (int row = y; row < y + h; row++) {
+        gfx_blend_span(gfx_row(row) + x, w, color, alpha);
     }
 }
 
 void draw_rounded_rect_alpha(int x, int y, int w, int h, int r, uint32_t color, uint8_t alpha) {
-    uint32_t src_r = (color >> 16) & 0xFF;
-    uint32_t src_g = (color >> 8) & 0xFF;
-    uint32_t src_b = color & 0xFF;
-
-    for (int i = 0; i < h; i++) {
-        for (int j = 0; j < w; j++) {
-            int px = x + j;
-            int py = y + i;
-            if (px < 0 || px >= (int)scr_width || py < 0 || py >= (int)scr_height) continue;
-
-            // Corner Clipping Logic
-            int is_corner = 0;
-            int cx = -1, cy = -1;
-
-            if (j < r && i < r) { cx = x + r; cy = y + r; is_corner = 1; }
-            else if (j >= w - r && i < r) { cx = x + w - r - 1; cy = y + r; is_corner = 1; }
-            else if (j < r && i >= h - r) { cx = x + r; cy = y + h - r - 1; is_corner = 1; }
-            else if (j >= w - r && i >= h - r) { cx = x + w - r - 1; cy = y + h - r - 1; is_corner = 1; }
-
-            if (is_corner) {
-                int dx = px - cx;
-                int dy = py - cy;
-                if (dx * dx + dy * dy > r * r) continue; // Clip pixel
-            }
-
-            if (alpha == 255) {
-                draw_pixel(px, py, color);
-            } else {
-                uint32_t dest_col = get_pixel(px, py);
-                uint32_t dest_r = (dest_col >> 16) & 0xFF;
-                uint32_t dest_g = (dest_col >> 8) & 0xFF;
-                uint32_t dest_b = dest_col & 0xFF;
-
-                uint32_t res_r = (src_r * alpha + dest_r * (255 - alpha)) >> 8;
-                uint32_t res_g = (src_g * alpha + dest_g * (255 - alpha)) >> 8;
-                uint32_t res_b = (src_b * alpha + dest_b * (255 - alpha)) >> 8;
-
-                draw_pixel(px, py, (res_r << 16) | (res_g << 8) | res_b);
-            }
-        }
-    }
+    gfx_fill_rounded(x, y, w, h, r, color, alpha);
 }
 
 void clear_screen(uint32_t color);
 uint32_t get_wallpaper_color();
 
 void draw_wallpaper() {
-    if (!wallpaper_ptr) {
+    if (!wallpaper_draw(get_wallpaper_color())) {
         clear_screen(get_wallpaper_color());
-        return;
-    }
-    
-    uint8_t* bmp8 = (uint8_t*)wallpaper_ptr;
-    if (bmp8[0] != 'B' || bmp8[1] != 'M') {
-        clear_screen(get_wallpaper_color());
-        return;
-    }
-    
-    uint32_t offset = *(uint32_t*)&bmp8[10];
-    uint32_t w = *(uint32_t*)&bmp8[18];
-    uint32_t h = *(uint32_t*)&bmp8[22];
-    uint16_t bpp_img = *(uint16_t*)&bmp8[28];
-    
-    if (bpp_img != 24 && bpp_img != 32) {
-        clear_screen(get_wallpaper_color());
-        return;
-    }
-    
-    uint8_t* pixel_data = bmp8 + offset;
-    int row_stride = (w * (bpp_img / 8) + 3) & ~3;
-    
-    for (int y = 0; y < (int)h; y++) {
-        int draw_y = scr_height - 1 - y;
-        if (draw_y < 0 || draw_y >= (int)scr_height) continue;
-        
-        uint8_t* row = pixel_data + (y * row_stride);
-        for (int x = 0; x < (int)w; x++) {
-            if (x >= (int)scr_width) break;
-            
-            uint32_t color = 0;
-            if (bpp_img == 24) {
-                uint8_t b_col = row[x*3];
-                uint8_t g_col = row[x*3+1];
-                uint8_t r_col = row[x*3+2];
-                color = (r_col << 16) | (g_col << 8) | b_col;
-            } else {
-                uint8_t b_col = row[x*4];
-                uint8_t g_col = row[x*4+1];
-                uint8_t r_col = row[x*4+2];
-                color = (r_col << 16) | (g_col << 8) | b_col;
-            }
-            draw_pixel(x, draw_y, color);
-        }
     }
 }
 
 void clear_screen(uint32_t color) {
-    if (!backbuffer) return;
-    draw_rect(0, 0, scr_width, scr_height, color);
+    gfx_fill_rect(0, 0, scr_width, scr_height, color);
+}
+
+// Present a rect, converting to the framebuffer's pixel format
+void swap_rect(int rx, int ry, int rw, int rh) {
+    if (!fb || !backbuffer || backbuffer == fb) return;
+    int cx = rx;
+    int copy_w = rw;
+    if (cx < 0) { copy_w += cx; cx = 0; }
+    if (cx + copy_w > (int)scr_width) copy_w = scr_width - cx;
+    if (copy_w <= 0) return;
+
+    for (int y = ry; y < ry + rh; y++) {
+        if (y < 0 || y >= (int)scr_height) continue;
+        uint8_t* dest = (uint8_t*)fb + y * fb_pitch + cx * fb_format->bytes_pp;
+        fb_format->store_span(dest, gfx_row(y) + cx, copy_w);
+    }
 }
 
 void swap_buffers() {
-    if (!fb || !backbuffer) return;
+    if (!fb || !backbuffer || backbuffer == fb) return;
+    if (!fb_format->native || fb_pitch != pitch) {
+        swap_rect(0, 0, scr_width, scr_height);
+        return;
+    }
     uint32_t dwords = (scr_height * pitch) / 4;
     void* dest = fb;
     void* src = backbuffer;
     asm volatile("rep movsl" : "+D"(dest), "+S"(src), "+c"(dwords) : : "memory");
 }
 
-void swap_rect(int rx, int ry, int rw, int rh) {
-    if (!fb || !backbuffer) return;
-    for (int y = ry; y < ry + rh; y++) {
-        if (y < 0 || y >= (int)scr_height) continue;
-        int cx = rx;
-        int copy_w = rw;
-        if (cx < 0) { copy_w += cx; cx = 0; }
-        if (cx + copy_w > (int)scr_width) copy_w = scr_width - cx;
-        if (copy_w <= 0) continue;
-        
-        uint32_t offset = (y * pitch) + (cx * (bpp / 8));
-        void* dest = (uint8_t*)fb + offset;
-        void* src = (uint8_t*)backbuffer + offset;
-        uint32_t bytes_to_copy = copy_w * (bpp / 8);
-        asm volatile("rep movsb" : "+D"(dest), "+S"(src), "+c"(bytes_to_copy) : : "memory");
-    }
-}
-
 // --- Text Drawing ---
 void draw_char(char c, int x, int y, uint32_t fg_color) {
-    if (c < 0) return;
-    const uint8_t *glyph = font8x8[(int)c];
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            if (glyph[row] & (1 << (7 - col))) {
-                draw_pixel(x + col, y + row, fg_color);
-            }
-        }
-    }
+    draw_text_run(&c, 1, x, y, fg_color);
 }
 
 void draw_string(const char* str, int x, int y, uint32_t fg) {
-    int cur_x = x;
-    while (*str) {
-        draw_char(*str, cur_x, y, fg);
-        cur_x += 8;
-        str++;
-    }
+    draw_text_run(str, -1, x, y, fg);
 }
 
 uint8_t read_cmos(uint8_t reg) {
@@ -348,12 +253,10 @@ char system_version[] = "1.3.0";
 char system_build[] = "Build 201";
 int mouse_x = 512;
 int mouse_y = 384;
-uint8_t mouse_cycle = 0;
-int8_t mouse_byte[3];
 int mouse_clicked = 0;
 int mouse_down = 0;
 int force_render_frame = 1;
-uint32_t timer_ticks = 0;
+void damage_topbar(int with_menu);
 uint32_t last_click_tick = 0;
 
 int is_dragging = 0;
@@ -415,8 +318,28 @@ int get_dock_hover_index() {
 Window win_bex;
 uint32_t* bex_canvas;
 void desktop_tick();
+void desktop_idle();
 void draw_bex_window();
 
+// Set once the app presents its own dirty rects with sys_window_present;
+// until then every sys_window_update shows the whole canvas
+int bex_explicit_present = 0;
+
+#define BEX_CANVAS_X 2
+#define BEX_CANVAS_Y 22
+
+// Damage part of the canvas, in canvas coordinates
+static void bex_damage_canvas(int x, int y, int w, int h) {
+    int cw = win_bex.w - 4;
+    int ch = win_bex.h - 24;
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > cw) w = cw - x;
+    if (y + h > ch) h = ch - y;
+    if (w <= 0 || h <= 0 || !win_bex.open || win_bex.minimized) return;
+    damage_add(win_bex.x + BEX_CANVAS_X + x, win_bex.y + BEX_CANVAS_Y + y, w, h);
+}
+
 Window* get_window_at_pos(int x, int y, int titlebar_only) {
     Window* windows[8] = {&win_terminal, &win_browser, &win_settings, &win_notepad, &win_explorer, &win_calc, &win_paint, &win_bex};
     for (int i=0; i<8; i++) {
@@ -454,10 +377,10 @@ int handle_window_controls(Window* win) {
 
 void check_click() {
     // 1. Core Click Timing
-    if (timer_ticks - last_click_tick < 60) { // ~600ms
+    if (ticks() - last_click_tick < 600) { // ~600ms
         // Note: is_double_click removed as per single-click requirement
     }
-    last_click_tick = timer_ticks;
+    last_click_tick = ticks();
 
 
     // --- Topbar BananaOS menu ---
@@ -465,7 +388,7 @@ if (mouse_y >= 0 && mouse_y <= 25) {
     // BananaOS text hitbox (approximate width 80px)
     if (mouse_x >= 10 && mouse_x <= 100) {
         topbar_menu_open = !topbar_menu_open;
-        force_render_frame = 1;
+        damage_topbar(1);
         return;
     }
     }
@@ -526,25 +449,25 @@ if (mouse_y >= 0 && mouse_y <= 25) {
     // 2. Dock Checks
     int hover_idx = get_dock_hover_index();
     if (hover_idx == 0) { 
-        win_terminal.open = !win_terminal.open; win_terminal.minimized = 0; force_render_frame = 1; return; 
+        win_terminal.open = !win_terminal.open; win_terminal.minimized = 0; damage_window(&win_terminal); return; 
     }
     if (hover_idx == 1) { 
-        win_calc.open = !win_calc.open; win_calc.minimized = 0; force_render_frame = 1; return; 
+        win_calc.open = !win_calc.open; win_calc.minimized = 0; damage_window(&win_calc); return; 
     }
     if (hover_idx == 2) { 
-        win_notepad.open = !win_notepad.open; win_notepad.minimized = 0; force_render_frame = 1; return; 
+        win_notepad.open = !win_notepad.open; win_notepad.minimized = 0; damage_window(&win_notepad); return; 
     }
     if (hover_idx == 3) { 
-        win_explorer.open = !win_explorer.open; win_explorer.minimized = 0; force_render_frame = 1; return; 
+        win_explorer.open = !win_explorer.open; win_explorer.minimized = 0; damage_window(&win_explorer); return; 
     }
     if (hover_idx == 4) { 
-        win_settings.open = !win_settings.open; win_settings.minimized = 0; force_render_frame = 1; return; 
+        win_settings.open = !win_settings.open; win_settings.minimized = 0; damage_window(&win_settings); return; 
     }
     if (hover_idx == 5) { 
-        win_browser.open = !win_browser.open; win_browser.minimized = 0; force_render_frame = 1; return; 
+        win_browser.open = !win_browser.open; win_browser.minimized = 0; damage_window(&win_browser); return; 
     }
     if (hover_idx == 6) { 
-        win_paint.open = !win_paint.open; win_paint.minimized = 0; force_render_frame = 1; return; 
+        win_paint.open = !win_paint.open; win_paint.minimized = 0; damage_window(&win_paint); return; 
     }
     
     Window* clicked_win = get_window_at_pos(mouse_x, mouse_y, 0);
@@ -561,7 +484,7 @@ if (mouse_y >= 0 && mouse_y <= 25) {
                 int by = win_explorer.y + 40 + (btn_count * 30);
                 if (mouse_y >= by && mouse_y <= by + 25) {
                     explorer_init(d);
-                    force_render_frame = 1;
+                    window_invalidate(&win_explorer);
                     return;
                 }
                 btn_count++;
@@ -572,7 +495,7 @@ if (mouse_y >= 0 && mouse_y <= 25) {
                 int by = win_explorer.y + 40 + (btn_count * 30);
                 if (mouse_y >= by && mouse_y <= by + 25) {
                     explorer_init(d+2);
-                    force_render_frame = 1;
+                    window_invalidate(&win_explorer);
                     return;
                 }
                 btn_count++;
@@ -596,7 +519,6 @@ if (mouse_y >= 0 && mouse_y <= 25) {
             return;
         }
         if (clicked_win == &win_paint && paint_handle_click(mouse_x, mouse_y)) {
-            force_render_frame = 1;
             return;
         }
         if (mouse_y <= clicked_win->y + 20) {
@@ -614,10 +536,10 @@ if (mouse_y >= 0 && mouse_y <= 25) {
             // Sidebar Hitboxes (X: 10 to 110 inside window)
             if (mouse_x >= set_x && mouse_x <= set_x + 120) {
                 if (mouse_y >= set_y + 30 && mouse_y <= set_y + 60) {
-                    settings_page = 0; force_render_frame = 1; return;
+                    settings_page = 0; window_invalidate(&win_settings); return;
                 }
                 if (mouse_y >= set_y + 65 && mouse_y <= set_y + 95) {
-                    settings_page = 1; force_render_frame = 1; return;
+                    settings_page = 1; window_invalidate(&win_settings); return;
                 }
             }
             
@@ -691,7 +613,7 @@ if (mouse_y >= 0 && mouse_y <= 25) {
                                 calc_op = '+'; calc_current = 0;
                             }
                         }
-                        force_render_frame = 1; return;
+                        window_invalidate(&win_calc); return;
                     }
                 }
             }
@@ -705,21 +627,12 @@ if (mouse_y >= 0 && mouse_y <= 25) {
         int btn_y = win_dialog.y + 150;
         if (mouse_x >= btn_x && mouse_x <= btn_x + btn_w && mouse_y >= btn_y && mouse_y <= btn_y + btn_h) {
             win_dialog.open = 0;
-            force_render_frame = 1;
+            damage_window(&win_dialog);
             return;
         }
     }
 }
 
-// --- View Rendering ---
-void draw_pixel_fb(int x, int y, uint32_t color) {
-    if (x < 0 || x >= (int)scr_width || y < 0 || y >= (int)scr_height || !fb) return;
-    uint32_t offset = (y * pitch) + (x * 4);
-    *(uint32_t*)((uint8_t*)fb + offset) = color;
-}
-
-
-
 void kstrcpy(char* dest, const char* src) {
     while (*src) {
         *dest++ = *src++;
@@ -727,51 +640,7 @@ void kstrcpy(char* dest, const char* src) {
     *dest = '\0';
 }
 
-void draw_cursor_direct(int x, int y) {
-
-    // Save background pixels
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-
-            int px = x + j;
-            int py = y + i;
-
-            if (px < 0 || px >= (int)scr_width ||
-                py < 0 || py >= (int)scr_height)
-                continue;
-
-            uint32_t offset = py * pitch + px * 4;
-            cursor_backup[i * 8 + j] =
-                *(uint32_t*)((uint8_t*)fb + offset);
-        }
-    }
-
-    // Draw white 8x8 cursor
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            draw_pixel_fb(x + j, y + i, 0xFFFFFF);
-        }
-    }
-}
-
-void restore_cursor(int x, int y) {
-
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-
-            int px = x + j;
-            int py = y + i;
-
-            if (px < 0 || px >= (int)scr_width ||
-                py < 0 || py >= (int)scr_height)
-                continue;
-
-            uint32_t offset = py * pitch + px * 4;
-            *(uint32_t*)((uint8_t*)fb + offset) =
-                cursor_backup[i * 8 + j];
-        }
-    }
-}
+// --- View Rendering ---
 void draw_dock() {
     int dock_w = 460;
     int dock_h = 60;
@@ -817,37 +686,25 @@ void draw_dock() {
     }
 }
 
-static inline uint32_t blur_pixel(uint32_t a, uint32_t b, uint32_t c,
-                                  uint32_t d, uint32_t e) {
-    uint32_t r = ((a>>16&255)+(b>>16&255)+(c>>16&255)+(d>>16&255)+(e>>16&255))/5;
-    uint32_t g = ((a>>8&255)+(b>>8&255)+(c>>8&255)+(d>>8&255)+(e>>8&255))/5;
-    uint32_t b2= ((a&255)+(b&255)+(c&255)+(d&255)+(e&255))/5;
-    return (r<<16)|(g<<8)|b2;
-}
+static int backdrop_is_wallpaper(Window* above, int x, int y, int w, int h);
 
-void blur_rect(int x, int y, int w, int h) {
-    uint8_t* base = (uint8_t*)backbuffer;
-    for (int j = y+1; j < y+h-1; j++) {
-        for (int i = x+1; i < x+w-1; i++) {
-            uint32_t offset = j * pitch + i * 4;
-            uint32_t* p = (uint32_t*)(base + offset);
-
-            uint32_t up    = *(uint32_t*)(base + (j-1)*pitch + i*4);
-            uint32_t down  = *(uint32_t*)(base + (j+1)*pitch + i*4);
-            uint32_t left  = *(uint32_t*)(base + j*pitch + (i-1)*4);
-            uint32_t right = *(uint32_t*)(base + j*pitch + (i+1)*4);
-            uint32_t mid   = *p;
-
-            *p = blur_pixel(up, down, left, right, mid);
-        }
+// Frosted glass: blur whatever is behind (x, y, w, h). Over bare
+// wallpaper that's a copy from the pre-blurred layer.
+static void blur_backdrop(Window* above, int x, int y, int w, int h) {
+    // Overrunning frames fall back to a plain tint
+    if (frame_effects_reduced) return;
+    if (backdrop_is_wallpaper(above, x, y, w, h) &&
+        wallpaper_draw_blurred(x, y, w, h, get_wallpaper_color())) {
+        return;
     }
+    gfx_blur_rect(x, y, w, h, BLUR_RADIUS);
 }
 
 void draw_topbar() {
     int bar_h = 25;
 
     // Blur what is already rendered
-    blur_rect(0, 0, scr_width, bar_h);
+    blur_backdrop(NULL, 0, 0, scr_width, bar_h);
 
     // Subtle glass tint (optional)
     draw_rect_alpha(0, 0, scr_width, bar_h, 0xFFFFFF, 40);
@@ -888,44 +745,88 @@ void draw_topbar() {
     }
 }
 
+// The part of the frame that sits under the app's content
+static void draw_window_body(Window* win) {
+    if (frosted_glass) {
+        const int glass_h = 26;
+        draw_rect(win->x, win->y + glass_h, win->w, win->h - glass_h, get_window_color());
+    } else if (rounded_win) {
+        draw_rounded_rect_alpha(win->x, win->y, win->w, win->h, 15, get_window_color(), 255);
+    } else {
+        draw_rect(win->x, win->y, win->w, win->h, get_window_color());
+    }
+}
+
+// --- Window Chrome Cache ---
+// Shadow, titlebar and rounded body as nine-slices, rebuilt only when the
+// theme or the window style toggles change.
+static NineSlice chrome_shadow;
+static NineSlice chrome_titlebar;
+static NineSlice chrome_body;
+static int chrome_style = -1;
+
+static void chrome_update() {
+    int style = current_theme | (rounded_win << 1) | (frosted_glass << 2);
+    if (style == chrome_style) return;
+    chrome_style = style;
+
+    int r = rounded_win ? 15 : 0;
+    nine_slice_build(&chrome_shadow, r, 0x1A1C23, rounded_win ? 100 : 255);
+    if (frosted_glass) {
+        nine_slice_build(&chrome_titlebar, r, 0xFFFFFF, 90);
+    } else {
+        nine_slice_build(&chrome_titlebar, r, 0x333333, 255);
+    }
+    nine_slice_build(&chrome_body, r, get_window_color(), 255);
+}
+
 void draw_window_frame(Window* win) {
     if (!win->open || win->minimized) return;
 
+    // Shadow, glass and titlebar depend on what lies behind the window, so
+    // they're composited live; a retained surface only keeps the body
+    if (surface_active) {
+        draw_window_body(win);
+        return;
+    }
+
+    chrome_update();
+
     if (frosted_glass) {
         // Windows 7 Aero / Frosted Glass Style
         const int glass_h = 26;
-        if (rounded_win) {
-            // Shadow / Glow
-            draw_rounded_rect_alpha(win->x + 5, win->y + 5, win->w, win->h, 15, 0x1A1C23, 100);
-            
-            // Background blur (approximate by blurring what is under)
-            blur_rect(win->x, win->y, win->w, glass_h);
-            
-            // Glassy titlebar
-            draw_rounded_rect_alpha(win->x, win->y, win->w, glass_h, 15, 0xFFFFFF, 90);
+        GfxRect body = {win->x, win->y + glass_h, win->w, win->h - glass_h};
 
-            // Window content background
-            draw_rounded_rect_alpha(win->x, win->y + glass_h, win->w, win->h - glass_h, 0, get_window_color(), 255);
-        } else {
-            // Square glass
-            draw_rect(win->x + 5, win->y + 5, win->w, win->h, 0x1A1C23);
-            blur_rect(win->x, win->y, win->w, glass_h);
-            draw_rect_alpha(win->x, win->y, win->w, glass_h, 0xFFFFFF, 90);
-            draw_rect(win->x, win->y + glass_h, win->w, win->h - glass_h, get_window_color());
+        // Background blur, taken before our own shadow lands on it
+        blur_backdrop(win, win->x, win->y, win->w, glass_h);
+
+        // Shadow / Glow, only where the body won't cover it
+        if (!rounded_win || !frame_effects_reduced) {
+            nine_slice_draw(&chrome_shadow, win->x + 5, win->y + 5, win->w, win->h, &body, 0);
         }
+
+        // Glassy titlebar
+        nine_slice_draw(&chrome_titlebar, win->x, win->y, win->w, glass_h, NULL, 0);
+
+        // Window content background
+        draw_rect(body.x, body.y, body.w, body.h, get_window_color());
     } else {
         // Original rendering logic
+        GfxRect frame = {win->x, win->y, win->w, win->h};
         if (rounded_win) {
             // Shadow / Glow
-            draw_rounded_rect_alpha(win->x + 5, win->y + 5, win->w, win->h, 15, 0x1A1C23, 100);
-            // Background
-            draw_rounded_rect_alpha(win->x, win->y, win->w, win->h, 15, get_window_color(), 255);
+            if (!frame_effects_reduced) {
+                nine_slice_draw(&chrome_shadow, win->x + 5, win->y + 5, win->w, win->h, &frame, 15);
+            }
+            // Background, except the rows the title bar paints solid
+            GfxRect title_solid = {win->x, win->y + 10, win->w, 10};
+            nine_slice_draw(&chrome_body, win->x, win->y, win->w, win->h, &title_solid, 0);
             // Title bar
-            draw_rounded_rect_alpha(win->x, win->y, win->w, 20, 15, 0x333333, 255);
+            nine_slice_draw(&chrome_titlebar, win->x, win->y, win->w, 20, NULL, 0);
             // Straight bottom for the title bar if needed, but 15px radius at top is enough
             draw_rect(win->x, win->y + 10, win->w, 10, 0x333333);
         } else {
-            draw_rect(win->x + 5, win->y + 5, win->w, win->h, 0x1A1C23); 
+            nine_slice_draw(&chrome_shadow, win->x + 5, win->y + 5, win->w, win->h, &frame, 0);
             draw_rect(win->x, win->y, win->w, win->h, get_window_color()); 
             draw_rect(win->x, win->y, win->w, 20, 0x333333);   
         }
@@ -1106,6 +1007,8 @@ void isr6_handler(Registers* regs) {
 }
 
 extern void as_isr128();
+extern void as_ipi_wake();
+extern void as_ipi_spurious();
 extern void return_to_kernel();
 
 void isr128_handler(Registers* regs) {
@@ -1148,9 +1051,12 @@ void isr128_handler(Registers* regs) {
         win_bex.title[j] = '\0';
         
         bex_canvas = buffer;
+        bex_explicit_present = 0;
         force_render_frame = 1;
     } else if (regs->eax == 5) { // sys_window_update (yield)
+        if (!bex_explicit_present) bex_damage_canvas(0, 0, win_bex.w, win_bex.h);
         desktop_tick();
+        desktop_idle();
     } else if (regs->eax == 6) { // sys_get_event
         // ebx = ptr to int x, ecx = ptr to int y, edx = ptr to int clicked
         int* px = (int*)regs->ebx;
@@ -1158,11 +1064,15 @@ void isr128_handler(Registers* regs) {
         int* pclick = (int*)regs->edx;
         
         // Return relative to bex window client area
-        *px = mouse_x - (win_bex.x + 2);
-        *py = mouse_y - (win_bex.y + 22);
+        *px = mouse_x - (win_bex.x + BEX_CANVAS_X);
+        *py = mouse_y - (win_bex.y + BEX_CANVAS_Y);
         extern int bex_window_clicked;
         *pclick = bex_window_clicked;
         bex_window_clicked = 0;
+    } else if (regs->eax == 7) { // sys_window_present
+        // ebx = x, ecx = y, edx = w, esi = h of the canvas rect that changed
+        bex_explicit_present = 1;
+        bex_damage_canvas((int)regs->ebx, (int)regs->ecx, (int)regs->edx, (int)regs->esi);
     }
 }
 
@@ -1170,7 +1080,13 @@ void idt_install() {
     idtp.limit = (sizeof(struct idt_entry) * 256) - 1; idtp.base = (uint32_t)&idt; 
     asm volatile("lidt %0" : : "m" (idtp));
     idt_set_gate(6, (uint32_t)as_isr6, 0x08, 0x8E);
-    idt_set_gate(128, (uint32_t)as_isr128, 0x08, 0x8E);
+    for (int i = 0; i < IRQ_COUNT; i++) {
+        idt_set_gate(IRQ_BASE + i, irq_stubs[i], 0x08, 0x8E);
+    }
+    // Trap gate: syscalls leave interrupts on, so the clock keeps running
+    idt_set_gate(128, (uint32_t)as_isr128, 0x08, 0x8F);
+    idt_set_gate(SMP_WAKE_VECTOR, (uint32_t)as_ipi_wake, 0x08, 0x8E);
+    idt_set_gate(LAPIC_SPURIOUS, (uint32_t)as_ipi_spurious, 0x08, 0x8E);
 }
 
 void acpi_shutdown() {
@@ -1199,82 +1115,48 @@ void safe_power_message() {
 
 
 // --- PS/2 Input Handling ---
-void poll_ps2() {
-    uint8_t status = inb(0x64);
-    while (status & 0x01) { 
-        uint8_t is_mouse = status & 0x20;
-        uint8_t port_data = inb(0x60);
-        
-        if (is_mouse) {
-            switch(mouse_cycle) {
-case 0:
-    if (!(port_data & 0x08)) {
-        mouse_cycle = 0;     // Needed for the Break Dump 
-        break;
-    }
-
-    mouse_byte[0] = port_data;
-    mouse_cycle++;     // I hope this wont break things
-    break;
-                case 1:
-                    mouse_byte[1] = port_data; mouse_cycle++;
-                    break;   // Added in Build 119
-                case 2:
-    mouse_byte[2] = port_data; 
-    mouse_cycle = 0;
-    // Ignore overflow packets and Continue
-    if (mouse_byte[0] & 0xC0)
-    break;
-
-                int dx = (int8_t)mouse_byte[1];
-                int dy = (int8_t)mouse_byte[2];
-
-                mouse_x += dx;
-                mouse_y -= dy;
-
-
-                    
-                    int new_btn = mouse_byte[0] & 0x01;
-                    if (new_btn && !mouse_down) {
-                        mouse_clicked = 1;
-                    }
-                    mouse_down = new_btn;
-                    
-                    if (mouse_x < 0) mouse_x = 0;
-                    if (mouse_y < 0) mouse_y = 0;
-                    if (mouse_x >= (int)scr_width) mouse_x = scr_width - 8;
-                    if (mouse_y >= (int)scr_height) mouse_y = scr_height - 8;
-                    
-                    break;
-            }
-        } else {
-            // Keyboard Input
-            if (port_data & 0x80) { // Break code (release)
-                uint8_t released = port_data & 0x7F;
-                if (released == 0x2A || released == 0x36) shift_active = 0;
-            } else { // Make code (press)
-                if (port_data == 0x2A || port_data == 0x36) {
-                    shift_active = 1;
-                } else if (port_data < 128) {
-                    char c = shift_active ? scancode_ascii_shift[port_data] : scancode_ascii[port_data];
-                    if (c && win_terminal.open && !win_terminal.minimized) {
-                        terminal_handle_key(c);
-                    } else if (c && win_browser.open && !win_browser.minimized) {
-                        browser_handle_key(c);
-                    } else if (c && win_notepad.open && !win_notepad.minimized) {
-                        if (c == '\b') {
-                            if (notepad_len > 0) notepad_len--;
-                        } else {
-                            if (notepad_len < 1023) {
-                                notepad_buf[notepad_len++] = c;
-                            }
-                        }
-                        force_render_frame = 1; // Update screen instantly as we type
-                    }
-                }
-            }
+static void handle_key(const InputEvent* ev) {
+    // 0xE0-prefixed shifts are fake ones sent around the cursor keys
+    if (ev->code == 0x2A || ev->code == 0x36) {
+        if (!(ev->flags & INPUT_KEY_EXTENDED)) shift_active = !(ev->flags & INPUT_KEY_RELEASE);
+        return;
+    }
+    if (ev->flags & INPUT_KEY_RELEASE) return;
+
+    char c = shift_active ? scancode_ascii_shift[ev->code] : scancode_ascii[ev->code];
+    if (c && win_terminal.open && !win_terminal.minimized) {
+        terminal_handle_key(c);
+    } else if (c && win_browser.open && !win_browser.minimized) {
+        browser_handle_key(c);
+    } else if (c && win_notepad.open && !win_notepad.minimized) {
+        notepad_handle_key(c);
+    }
+}
+
+// Drain the event ring. A press stops the drain so the click is handled
+// where it happened; the events behind it wait for the next tick.
+void process_input() {
+    InputEvent ev;
+    while (input_pop(&ev)) {
+        if (ev.type == INPUT_KEY) {
+            handle_key(&ev);
+            continue;
+        }
+
+        mouse_x += ev.dx;
+        mouse_y -= ev.dy;
+        if (mouse_x < 0) mouse_x = 0;
+        if (mouse_y < 0) mouse_y = 0;
+        if (mouse_x >= (int)scr_width) mouse_x = scr_width - 8;
+        if (mouse_y >= (int)scr_height) mouse_y = scr_height - 8;
+
+        int new_btn = ev.flags & INPUT_BTN_LEFT;
+        int pressed = new_btn && !mouse_down;
+        mouse_down = new_btn;
+        if (pressed) {
+            mouse_clicked = 1;
+            return;
         }
-        status = inb(0x64); 
     }
 }
 // Implemented in Build 107
@@ -1296,47 +1178,370 @@ void reboot_system() {
 }
 
 extern void mouse_install();
-Window win_bex = {150, 150, 400, 300, 0, 0, 0, 150, 150, 400, 300, "BEX App"};
+Window win_bex = {150, 150, 400, 300, 0, 0, 0, 150, 150, 400, 300, "BEX App", {0}};
 uint32_t* bex_canvas = NULL;
 
+// The app's canvas is the window's surface; it is copied straight to the
+// backbuffer, one clipped row at a time, and only where damaged
 void draw_bex_window() {
     if (!win_bex.open || win_bex.minimized) return;
     draw_window_frame(&win_bex);
-    if (bex_canvas) {
-        int cx = win_bex.x + 2;
-        int cy = win_bex.y + 22;
-        int cw = win_bex.w - 4;
-        int ch = win_bex.h - 24;
-        for (int y = 0; y < ch; y++) {
-            for (int x = 0; x < cw; x++) {
-                draw_pixel(cx + x, cy + y, bex_canvas[y * cw + x]);
-            }
-        }
+    if (!bex_canvas || !backbuffer) return;
+
+    int cx = win_bex.x + BEX_CANVAS_X;
+    int cy = win_bex.y + BEX_CANVAS_Y;
+    int cw = win_bex.w - 4;
+    int ch = win_bex.h - 24;
+
+    int x = cx, y = cy, w = cw, h = ch;
+    if (!gfx_clip_rect(&x, &y, &w, &h)) return;
+    for (int row = y; row < y + h; row++) {
+        const uint32_t* src = bex_canvas + (row - cy) * cw + (x - cx);
+        uint32_t* dst = gfx_row(row) + x;
+        // Apps may leave junk in the top byte
+        for (int i = 0; i < w; i++) dst[i] = src[i] & 0x00FFFFFF;
     }
 }
 
+
 int last_hover_idx = -1;
 int last_drawn_mouse_x = -1;
 int last_drawn_mouse_y = -1;
 int bex_window_clicked = 0;
+int last_clock_minute = -1;
+uint64_t last_clock_check = 0;
+
+// --- Window Stack ---
+// Back-to-front compositing order
+typedef struct {
+    Window* win;
+    void (*draw)(void);
+} WindowLayer;
+
+static const WindowLayer window_layers[] = {
+    {&win_calc, draw_calculator},
+    {&win_explorer, draw_explorer},
+    {&win_notepad, draw_notepad},
+    {&win_paint, draw_paint},
+    {&win_settings, draw_settings},
+    {&win_browser, draw_browser},
+    {&win_terminal, draw_terminal},
+    {&win_bex, draw_bex_window},
+    {&win_dialog, draw_dialog},
+};
+
+#define WINDOW_SHADOW 5
+// Height of the frosted glass titlebar and corner radius of rounded
+// windows, as drawn by draw_window_frame
+#define WINDOW_GLASS_H 26
+#define WINDOW_RADIUS 15
+
+// A window covers its own rect plus the drop shadow below and to the right
+void damage_window(Window* win) {
+    damage_add(win->x, win->y, win->w + WINDOW_SHADOW, win->h + WINDOW_SHADOW);
+}
+
+void damage_topbar(int with_menu) {
+    damage_add(0, 0, scr_width, 25);
+    if (with_menu) damage_add(10, 25, 170, 90);
+}
+
+static void damage_dock() {
+    int dock_w = 460;
+    int dock_h = 60;
+    damage_add((scr_width - dock_w) / 2, scr_height - dock_h - 10, dock_w, dock_h);
+}
+
+void window_invalidate(Window* win) {
+    win->surface.dirty = 1;
+    damage_window(win);
+}
+
+void window_invalidate_rect(Window* win, int x, int y, int w, int h) {
+    WindowSurface* s = &win->surface;
+    int x0 = x - win->x;
+    int y0 = y - (win->y + WINDOW_TITLEBAR_H);
+    int x1 = x0 + w;
+    int y1 = y0 + h;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > win->w) x1 = win->w;
+    if (y1 > win->h - WINDOW_TITLEBAR_H) y1 = win->h - WINDOW_TITLEBAR_H;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    if (s->dirty_x1 > s->dirty_x0) {
+        if (s->dirty_x0 < x0) x0 = s->dirty_x0;
+        if (s->dirty_y0 < y0) y0 = s->dirty_y0;
+        if (s->dirty_x1 > x1) x1 = s->dirty_x1;
+        if (s->dirty_y1 > y1) y1 = s->dirty_y1;
+    }
+    s->dirty_x0 = x0;
+    s->dirty_y0 = y0;
+    s->dirty_x1 = x1;
+    s->dirty_y1 = y1;
+    damage_add(win->x + x0, win->y + WINDOW_TITLEBAR_H + y0, x1 - x0, y1 - y0);
+}
+
+static void invalidate_all_windows() {
+    for (unsigned i = 0; i < sizeof(window_layers) / sizeof(window_layers[0]); i++) {
+        window_layers[i].win->surface.dirty = 1;
+    }
+}
+
+// Make sure the window has a surface matching its current size.
+// Returns 0 if it has to be drawn directly instead.
+static int window_prepare_surface(Window* win) {
+    int sw = win->w;
+    int sh = win->h - WINDOW_TITLEBAR_H;
+    if (backbuffer == fb || sw <= 0 || sh <= 0) return 0;
+    // The BEX canvas already is the retained content
+    if (win == &win_bex) return 0;
+
+    uint32_t need = (uint32_t)sw * sh;
+    if (!win->surface.pixels || need > win->surface.cap) {
+        // The arena never frees; a window that grows just takes a bigger block
+        uint32_t* p = surface_alloc(need);
+        if (!p) return 0;
+        win->surface.pixels = p;
+        win->surface.cap = need;
+        win->surface.dirty = 1;
+    }
+    if (sw != win->surface.w || sh != win->surface.h) {
+        win->surface.w = sw;
+        win->surface.h = sh;
+        win->surface.dirty = 1;
+    }
+    return 1;
+}
+
+static void composite_window(const WindowLayer* layer) {
+    Window* win = layer->win;
+    if (!window_prepare_surface(win)) {
+        layer->draw();
+        return;
+    }
+
+    int cy = win->y + WINDOW_TITLEBAR_H;
+    WindowSurface* s = &win->surface;
+    if (s->dirty) {
+        surface_begin(s->pixels, win->x, cy, s->w, s->h);
+        layer->draw();
+        surface_end();
+        s->dirty = 0;
+    } else if (s->dirty_x1 > s->dirty_x0) {
+        surface_begin_rect(s->pixels, win->x, cy, s->w, s->h,
+                           win->x + s->dirty_x0, cy + s->dirty_y0,
+                           s->dirty_x1 - s->dirty_x0, s->dirty_y1 - s->dirty_y0);
+        layer->draw();
+        surface_end();
+    }
+    s->dirty_x1 = s->dirty_x0;
+
+    draw_window_frame(win);
+    surface_blit(win->surface.pixels, win->x, cy, win->surface.w, win->surface.h);
+}
+
+// Only wallpaper lies under (x, y, w, h) if no window below `above`
+// (every window when NULL) overlaps it, shadow included
+static int backdrop_is_wallpaper(Window* above, int x, int y, int w, int h) {
+    GfxRect r = {x, y, w, h};
+    for (unsigned i = 0; i < sizeof(window_layers) / sizeof(window_layers[0]); i++) {
+        Window* win = window_layers[i].win;
+        if (win == above) break;
+        if (!win->open || win->minimized) continue;
+        if (rect_intersects(&r, win->x, win->y, win->w + WINDOW_SHADOW, win->h + WINDOW_SHADOW)) return 0;
+    }
+    return 1;
+}
+
+// Recomposite everything that intersects the current clip rect
+// --- Frame Recording ---
+// Each frame is recorded as a display list once and then replayed per
+// damage rect, so layers hidden under opaque windows are never drawn.
+static DisplayList frame_list;
+
+static void draw_wallpaper_item(void* ctx) { (void)ctx; draw_wallpaper(); }
+static void draw_window_item(void* ctx) { composite_window((const WindowLayer*)ctx); }
+static void draw_dock_item(void* ctx) { (void)ctx; draw_dock(); }
+static void draw_topbar_item(void* ctx) { (void)ctx; draw_topbar(); }
+
+// The part of a window every style paints solid. The glass titlebar,
+// rounded corners and the shadow all let what's below show through.
+static GfxRect window_opaque_rect(Window* win) {
+    if (frosted_glass) {
+        return (GfxRect){win->x, win->y + WINDOW_GLASS_H, win->w, win->h - WINDOW_GLASS_H};
+    }
+    if (rounded_win) {
+        return (GfxRect){win->x, win->y + WINDOW_RADIUS, win->w, win->h - 2 * WINDOW_RADIUS};
+    }
+    return (GfxRect){win->x, win->y, win->w, win->h};
+}
+
+static void record_frame() {
+    GfxRect screen = {0, 0, (int)scr_width, (int)scr_height};
+    displist_reset(&frame_list);
+    displist_add(&frame_list, draw_wallpaper_item, NULL, &screen, &screen, NULL);
+
+    for (unsigned i = 0; i < sizeof(window_layers) / sizeof(window_layers[0]); i++) {
+        Window* w = window_layers[i].win;
+        if (!w->open || w->minimized) continue;
+        GfxRect bounds = {w->x, w->y, w->w + WINDOW_SHADOW, w->h + WINDOW_SHADOW};
+        GfxRect opaque = window_opaque_rect(w);
+        // The glass titlebar blurs what's under it, a little past its edges
+        GfxRect glass = {w->x - BLUR_RADIUS, w->y - BLUR_RADIUS,
+                         w->w + 2 * BLUR_RADIUS, WINDOW_GLASS_H + 2 * BLUR_RADIUS};
+        displist_add(&frame_list, draw_window_item, (void*)&window_layers[i],
+                     &bounds, &opaque, frosted_glass ? &glass : NULL);
+    }
+
+    int dock_w = 460;
+    int dock_h = 60;
+    GfxRect dock = {((int)scr_width - dock_w) / 2, (int)scr_height - dock_h - 10, dock_w, dock_h};
+    displist_add(&frame_list, draw_dock_item, NULL, &dock, NULL, NULL);
+
+    GfxRect topbar = {0, 0, (int)scr_width, topbar_menu_open ? 25 + 90 : 25};
+    GfxRect topbar_blur = {0, 0, (int)scr_width, 25 + BLUR_RADIUS};
+    displist_add(&frame_list, draw_topbar_item, NULL, &topbar, NULL, &topbar_blur);
+}
+
+static void compose_region(const GfxRect* clip) {
+    displist_execute(&frame_list, clip);
+}
+
+// A blur reads past the clip, and outside it the backbuffer still holds
+// last frame's blurred and tinted glass. Damage touching a glass layer's
+// backdrop is widened to the whole backdrop so the blur only reads
+// freshly composited pixels; otherwise the damage edges show seams.
+static void damage_cover_backdrops() {
+    // Widening can reach another backdrop, and so can the merges
+    // damage_add does, so go again until nothing grows
+    for (int pass = 0; pass < DISPLAY_MAX_ITEMS && !damage.full; pass++) {
+        DamageList in = damage;
+        int grown = 0;
+        damage.count = 0;
+        for (int i = 0; i < in.count; i++) {
+            GfxRect r = in.rects[i];
+            for (int k = 0; k < frame_list.count; k++) {
+                const GfxRect* b = &frame_list.items[k].backdrop;
+                if (b->w <= 0 || !rect_intersects(&r, b->x, b->y, b->w, b->h)) continue;
+                // damage_add clips to the screen, so compare against that
+                int bx0 = b->x < 0 ? 0 : b->x;
+                int by0 = b->y < 0 ? 0 : b->y;
+                int bx1 = b->x + b->w > (int)scr_width ? (int)scr_width : b->x + b->w;
+                int by1 = b->y + b->h > (int)scr_height ? (int)scr_height : b->y + b->h;
+                int x0 = r.x < bx0 ? r.x : bx0;
+                int y0 = r.y < by0 ? r.y : by0;
+                int x1 = r.x + r.w > bx1 ? r.x + r.w : bx1;
+                int y1 = r.y + r.h > by1 ? r.y + r.h : by1;
+                if (x0 == r.x && y0 == r.y && x1 == r.x + r.w && y1 == r.y + r.h) continue;
+                r = (GfxRect){x0, y0, x1 - x0, y1 - y0};
+                grown = 1;
+            }
+            damage_add(r.x, r.y, r.w, r.h);
+        }
+        if (!grown) break;
+    }
+}
+
+// --- Page Flipping ---
+// When BGA flipping is on, backbuffer is the next VRAM page. It last went
+// on screen (bga_page_count - 1) frames ago, so it also misses the damage
+// of every frame since; those lists are replayed before compositing.
+static DamageList flip_history[BGA_MAX_PAGES - 1];
+static int front_page = 0;
+
+static void flip_init(void) {
+    front_page = 0;
+    fb = bga_page(0);
+    backbuffer = bga_page(1);
+    // Every page starts out stale
+    for (int i = 0; i < BGA_MAX_PAGES - 1; i++) {
+        flip_history[i].count = 0;
+        flip_history[i].full = 1;
+    }
+}
+
+static void flip_replay_damage(DamageList* frame) {
+    *frame = damage;
+    for (int i = 0; i < bga_page_count - 1; i++) damage_merge(&flip_history[i]);
+}
+
+static void flip_present(const DamageList* frame) {
+    for (int i = bga_page_count - 2; i > 0; i--) flip_history[i] = flip_history[i - 1];
+    flip_history[0] = *frame;
+
+    front_page = (front_page + 1) % bga_page_count;
+    cursor_flip_prepare(bga_page(front_page));
+    bga_show_page(front_page);
+    cursor_flip_done();
+    fb = bga_page(front_page);
+    backbuffer = bga_page((front_page + 1) % bga_page_count);
+}
+
+static void render_damage() {
+    DamageList frame;
+    // A flipped frame is composed off screen, so the sprite can stay up;
+    // the copy path may overwrite it and needs it gone first
+    if (!bga_page_count) cursor_hide();
+
+    if (bga_page_count) flip_replay_damage(&frame);
+
+    record_frame();
+    damage_cover_backdrops();
+    display_stats = (DisplayStats){0, 0, 0, 0};
+
+    if (damage.full) {
+        GfxRect screen = {0, 0, (int)scr_width, (int)scr_height};
+        compose_region(&screen);
+        if (!bga_page_count) swap_buffers();
+    } else {
+        for (int i = 0; i < damage.count; i++) {
+            compose_region(&damage.rects[i]);
+        }
+
+        // Present only what changed
+        for (int i = 0; i < damage.count && !bga_page_count; i++) {
+            GfxRect* r = &damage.rects[i];
+            swap_rect(r->x, r->y, r->w, r->h);
+        }
+    }
+    if (bga_page_count) flip_present(&frame);
+    damage_clear();
+
+    // The present may have covered the sprite; this also repairs the
+    // spot it moved away from
+    cursor_move(mouse_x, mouse_y);
+    last_drawn_mouse_x = mouse_x;
+    last_drawn_mouse_y = mouse_y;
+}
 
 void desktop_tick() {
-    poll_ps2();
+    process_input();
     e1000_poll();
     
     int current_hover_idx = get_dock_hover_index();
 
     if (current_hover_idx != last_hover_idx) {
-        // Only trigger full redraw if we ENTER or LEAVE a dock icon
-        if (current_hover_idx == -1 || last_hover_idx == -1) {
-            force_render_frame = 1;
-        }
+        damage_dock();
         last_hover_idx = current_hover_idx;
     }
 
-    if (win_paint.open && !win_paint.minimized && mouse_down &&
-        get_window_at_pos(mouse_x, mouse_y, 0) == &win_paint) {
-        paint_handle_mouse(mouse_x, mouse_y, 1);
+    // The clock only shows minutes; sample the RTC about once a second
+    uint64_t now = timer_now();
+    if (now - last_clock_check >= (uint64_t)timer_ticks_per_ms * 1000) {
+        last_clock_check = now;
+        int h, m, s;
+        get_rtc_time(&h, &m, &s);
+        if (m != last_clock_minute) {
+            if (last_clock_minute >= 0) damage_topbar(0);
+            last_clock_minute = m;
+        }
+    }
+
+    if (win_paint.open && !win_paint.minimized) {
+        // Releasing the button or leaving the window ends a stroke
+        int over = mouse_down && get_window_at_pos(mouse_x, mouse_y, 0) == &win_paint;
+        paint_handle_mouse(mouse_x, mouse_y, over);
     }
     if (mouse_clicked) {
         if (get_window_at_pos(mouse_x, mouse_y, 0) == &win_bex) {
@@ -1354,119 +1559,241 @@ void desktop_tick() {
             int nx = mouse_x - drag_offset_x;
             int ny = mouse_y - drag_offset_y;
             if (nx != dragged_window->x || ny != dragged_window->y) {
+                damage_window(dragged_window);
                 dragged_window->x = nx;
                 dragged_window->y = ny;
-                force_render_frame = 1;
+                damage_window(dragged_window);
             }
         }
     }
 
     if (force_render_frame) {
-        // Full 8MB rendering pipeline triggered by UI changes
-        draw_wallpaper(); 
-        
-        // Z-Order: Render windows from back to front
-        // In the future, a dynamic list would be better, but for now we follow this fixed order
-        // (Note: This is the same order as your original code, which is effectively the draw order)
-        draw_calculator();
-        draw_explorer();
-        draw_notepad();
-        draw_paint();
-        draw_settings();
-        draw_browser();
-        draw_terminal();
-        draw_bex_window();
-        
-        draw_dialog();
-        draw_dock(); 
-        draw_topbar();
-        
-        swap_buffers();
-        
-        // Draw initial cursor directly to VRAM
-        draw_cursor_direct(mouse_x, mouse_y);
-        
+        // Full redraws follow theme and layout changes, so repaint contents too
+        invalidate_all_windows();
+        damage_add_full();
         force_render_frame = 0;
-        last_drawn_mouse_x = mouse_x;
-        last_drawn_mouse_y = mouse_y;
-        
-    } else if (mouse_x != last_drawn_mouse_x || mouse_y != last_drawn_mouse_y) {
-        restore_cursor(last_drawn_mouse_x, last_drawn_mouse_y);
-        draw_cursor_direct(mouse_x, mouse_y);
+    }
+
+    // The sprite is cheap to move, so it follows the mouse between frames
+    if (mouse_x != last_drawn_mouse_x || mouse_y != last_drawn_mouse_y) {
+        cursor_move(mouse_x, mouse_y);
 
         last_drawn_mouse_x = mouse_x;
         last_drawn_mouse_y = mouse_y;
     }
 
-    // Lock rendering execution loop to simulated 60Hz VGA vblank
-    // This stops the main thread from requesting 1 Million MMIO port polls per second
-    while (inb(0x3DA) & 0x08); 
-    while (!(inb(0x3DA) & 0x08));
+    if (!frame_due()) return;
+
+    if (damage_pending()) {
+        frame_begin();
+        render_damage();
+        if (frame_end()) force_render_frame = 1;
+    } else {
+        frame_idle();
+    }
+}
+
+// Sleep until an interrupt unless input is already waiting. The 1 kHz
+// timer tick wakes us for the next frame and the NIC poll; input wakes
+// us on IRQ1/IRQ12.
+void desktop_idle() {
+    asm volatile("cli");
+    if (input_pending() || mouse_clicked || force_render_frame) {
+        asm volatile("sti");
+        return;
+    }
+    idle_halt();
+}
+
+// --- Boot Benchmark Mode ---
+// Booting with "bench" on the kernel command line runs the graphics
+// primitive suite instead of the desktop. Results go to the screen and
+// to COM1, so `qemu -serial stdio` can log them across builds.
+#define BENCH_LOG_LINES 56
+
+static char bench_log[BENCH_LOG_LINES][80];
+static int bench_log_count = 0;
+
+static int cmdline_has_flag(const char* cmdline, const char* flag) {
+    if (!cmdline) return 0;
+    while (*cmdline) {
+        while (*cmdline == ' ') cmdline++;
+        const char* f = flag;
+        while (*f && *cmdline == *f) { cmdline++; f++; }
+        if (!*f && (*cmdline == ' ' || *cmdline == '\0')) return 1;
+        while (*cmdline && *cmdline != ' ') cmdline++;
+    }
+    return 0;
+}
+
+static void serial_print(const char* line) {
+    serial_write(line);
+    serial_write("\n");
+}
+
+static void bench_print(const char* line) {
+    serial_write(line);
+    serial_write("\n");
+
+    if (bench_log_count < BENCH_LOG_LINES) {
+        int i = 0;
+        while (line[i] && i < 79) { bench_log[bench_log_count][i] = line[i]; i++; }
+        bench_log[bench_log_count][i] = '\0';
+        bench_log_count++;
+    }
+
+    // The benchmarks scribble over the backbuffer, so redraw the whole log
+    gfx_clip_reset();
+    clear_screen(0x101418);
+    for (int i = 0; i < bench_log_count; i++) {
+        draw_string(bench_log[i], 20, 20 + i * 12, 0xE0E0E0);
+    }
+    swap_buffers();
+}
+
+static void run_boot_bench() {
+    bench_print("BananaOS graphics benchmark");
+    gfx_bench_suite(bench_print);
+    gfx_bench_present(bench_print);
+    bench_print("Benchmark done.");
+    while (1) asm("hlt");
+}
+
+// --- Physical Memory ---
+// Window surfaces and wallpaper caches get at most this much
+#define SURFACE_ARENA_MAX (64 * 1024 * 1024)
+
+static void reserve_string(uint32_t addr) {
+    const char* str = (const char*)addr;
+    uint32_t len = 0;
+    while (str[len]) len++;
+    pmm_reserve(addr, len + 1);
+}
+
+// Build the page allocator before any driver asks it for memory, and keep
+// everything GRUB handed over out of it
+static void memory_init(struct multiboot_info* mbd) {
+    uint32_t mmap_length = (mbd->flags & (1 << 6)) ? mbd->mmap_length : 0;
+    uint32_t mem_upper = (mbd->flags & 1) ? mbd->mem_upper : 15 * 1024; // Fallback assumption: 16MB
+    pmm_init(mbd->mmap_addr, mmap_length, mem_upper);
+
+    pmm_reserve((uint32_t)mbd, sizeof(*mbd));
+    if (mmap_length) pmm_reserve(mbd->mmap_addr, mmap_length);
+    if (mbd->flags & (1 << 2)) reserve_string(mbd->cmdline);
+    if (mbd->flags & (1 << 3)) {
+        struct multiboot_mod_list* mods = (struct multiboot_mod_list*)mbd->mods_addr;
+        pmm_reserve(mbd->mods_addr, mbd->mods_count * sizeof(struct multiboot_mod_list));
+        for (uint32_t i = 0; i < mbd->mods_count; i++) {
+            pmm_reserve(mods[i].mod_start, mods[i].mod_end - mods[i].mod_start);
+            if (mods[i].cmdline) reserve_string(mods[i].cmdline);
+        }
+    }
+    // Some boards carve the framebuffer out of RAM the map calls usable
+    if ((mbd->flags & (1 << 12)) && !(mbd->framebuffer_addr >> 32)) {
+        pmm_reserve((uint32_t)mbd->framebuffer_addr, mbd->framebuffer_pitch * mbd->framebuffer_height);
+    }
+
+    total_ram_mb = (pmm_total_pages + 255) / 256;
 }
 
 void kernel_main(uint32_t magic, struct multiboot_info* mbd) {
     if (magic != 0x2BADB002) return;
     
+    cpu_detect();
+    memory_init(mbd);
+    paging_init();
+    loader_init();
+    timer_calibrate_tsc();
+    cpu_enable_simd();
+    blend_init();
+    cursor_init();
     gdt_install();
     idt_install();
+    pic_init();
+    timer_init();
+    asm volatile("sti");
     mouse_install();
+    input_init();
     ahci_init();
     e1000_init();
     acpi_supported = detect_acpi();
     
-    uint32_t highest_mod_end = 0x400000; 
     int has_wallpaper = 0;
     if (mbd->flags & (1 << 3)) {
         if (mbd->mods_count > 0) {
             struct multiboot_mod_list* mods = (struct multiboot_mod_list*)mbd->mods_addr;
-            for (uint32_t i = 0; i < mbd->mods_count; i++) {
-                if (mods[i].mod_end > highest_mod_end) highest_mod_end = mods[i].mod_end;
-            }
             wallpaper_ptr = (void*)mods[0].mod_start;
             has_wallpaper = 1;
         }
     }
 
-    if (mbd->flags & (1 << 12)) {
+    // Direct-colour modes only; color_info holds the channel layout
+    if ((mbd->flags & (1 << 12)) && mbd->framebuffer_type == 1 &&
+        pixfmt_select(mbd->framebuffer_bpp, mbd->color_info)) {
         fb = (uint32_t*)(uint32_t)mbd->framebuffer_addr;
         scr_width = mbd->framebuffer_width;
         scr_height = mbd->framebuffer_height;
-        pitch = mbd->framebuffer_pitch;
+        fb_pitch = mbd->framebuffer_pitch;
         bpp = mbd->framebuffer_bpp;
-        
-        uint32_t total_mem_bytes = 0;
-        if (mbd->flags & 1) {
-            total_mem_bytes = (mbd->mem_upper + 1024) * 1024;
-        } else {
-            total_mem_bytes = 16 * 1024 * 1024; // Fallback assumption
-        }
-        
-uint32_t bb_size = scr_width * scr_height * (bpp / 8);
 
-// Allocate backbuffer safely after kernel/modules
-uint32_t safe_start = highest_mod_end + 0x10000; // 64KB safety gap
-
-// Align to 4KB page boundary
-safe_start = (safe_start + 0xFFF) & ~0xFFF;
+        // Presents are streaming writes; let them combine instead of going
+        // out uncached. Covering the whole VRAM BAR takes far fewer MTRRs
+        // than carving out just the visible part.
+        uint32_t wc_base = (uint32_t)fb;
+        uint32_t wc_size = scr_height * fb_pitch;
+        pci_find_mem_bar(wc_base, &wc_base, &wc_size);
+        mtrr_set_wc(wc_base, wc_size);
+        paging_map(wc_base, wc_size, MEM_WC, "Framebuffer");
+        
+// The backbuffer is 32bpp whatever the display mode
+uint32_t bb_size = scr_width * scr_height * 4;
 
-uint32_t bb_addr = safe_start;
+// NULL when there is not enough RAM for double buffering
+backbuffer = (uint32_t*)pmm_alloc(bb_size);
 
-if (bb_addr + bb_size > total_mem_bytes) {
-    // Not enough RAM for double buffer
-    backbuffer = NULL;
+if (!backbuffer) {
+    // Drawing straight to VRAM only works when it shares our format
+    if (fb_format->native) {
+        backbuffer = fb;
+        pitch = fb_pitch;
+    }
 } else {
-    backbuffer = (uint32_t*)bb_addr;
+    pitch = scr_width * 4;
+    // Window surfaces take up to half of what is left, in one block
+    uint32_t arena_size = pmm_free_pages / 2 * PAGE_SIZE;
+    if (arena_size > SURFACE_ARENA_MAX) arena_size = SURFACE_ARENA_MAX;
+    uint32_t arena = 0;
+    while (arena_size >= 0x100000 && !(arena = pmm_alloc(arena_size))) arena_size /= 2;
+    if (arena) surface_arena_init(arena, arena + arena_size);
+}
+
+// Render into spare VRAM pages and flip instead of copying whole frames.
+// The RAM backbuffer stays allocated for the window surface arena and as
+// the copy path if the adapter is not there.
+if (backbuffer && backbuffer != fb && fb_format->native &&
+    bga_init((uint32_t)fb, fb_pitch, scr_height) >= 2) {
+    flip_init();
+    cursor_set_direct(1);
 }
 
-if (!backbuffer)
-    backbuffer = fb;
+        gfx_clip_reset();
 
 
 
         
     }
-    
-    total_ram_mb = (1024 + mbd->mem_upper) / 1024;
+
+    // Device registers must not be cached, whatever block they sit in
+    if (ahci_mmio_base()) paging_map(ahci_mmio_base(), sizeof(HBA_MEM), MEM_UC, "AHCI");
+    if (net_state.mmio_base) paging_map(net_state.mmio_base, E1000_MMIO_SIZE, MEM_UC, "e1000");
+    paging_enable();
+    serial_init();
+    paging_report(serial_print);
+    smp_init();
+    smp_report(serial_print);
+
+    // Resampling is split across the APs, so it waits for smp_init
+    if (backbuffer && has_wallpaper) wallpaper_load(wallpaper_ptr);
     
     if (total_ram_mb < 1) {
         // Critical System Halt
@@ -1488,10 +1815,17 @@ if (!backbuffer)
         // Log "CMOV: Emulated" (hidden or to debug)
     }
 
+    if ((mbd->flags & (1 << 2)) && cmdline_has_flag((const char*)mbd->cmdline, "bench")) {
+        run_boot_bench();
+    }
+
     get_cpu_info();
     explorer_init(0); // Initialize default drive for File Explorer
+
+    frame_init();
     
     while (1) {
         desktop_tick();
+        desktop_idle();
     }
 }
@@ -0,0 +1,257 @@
+#include "kmalloc.h"
+#include "pmm.h"
+
+#define SLAB_MAGIC  0x534C4142   // "SLAB"
+#define LARGE_MAGIC 0x4C415247   // "LARG"
+
+// Sits at the start of every slab page; objects follow at SLAB_OBJ_START
+typedef struct Slab {
+    uint32_t magic;
+    uint16_t cls;
+    uint16_t in_use;
+    struct Slab* prev;       // partial list links
+    struct Slab* next;
+    void* free;              // free objects, linked through their first word
+} Slab;
+
+#define SLAB_OBJ_START 32
+
+// Page-backed allocations keep their page count in front of the data
+typedef struct {
+    uint32_t magic;
+    uint32_t pages;
+    uint32_t pad[2];
+} LargeHeader;
+
+typedef struct {
+    Slab* partial;           // slabs with at least one free object
+    uint32_t empty;          // slabs on that list with nothing allocated
+} Cache;
+
+static Cache caches[KMALLOC_CLASSES];
+
+KmallocCacheStats kmalloc_stats[KMALLOC_CLASSES] = {
+    {16, 0, 0, 0, 0}, {32, 0, 0, 0, 0}, {64, 0, 0, 0, 0}, {128, 0, 0, 0, 0},
+    {256, 0, 0, 0, 0}, {512, 0, 0, 0, 0}, {1024, 0, 0, 0, 0},
+};
+uint32_t kmalloc_large_live = 0;
+uint32_t kmalloc_large_pages = 0;
+uint32_t kmalloc_failures = 0;
+
+static void k_memset(void* dst, uint8_t v, uint32_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    while (n--) *d++ = v;
+}
+
+static void k_memcpy(void* dst, const void* src, uint32_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    while (n--) *d++ = *s++;
+}
+
+static int size_class(uint32_t size) {
+    int cls = 0;
+    while (kmalloc_stats[cls].size < size) cls++;
+    return cls;
+}
+
+// --- Partial Lists ---
+static void partial_push(Cache* c, Slab* s) {
+    s->prev = 0;
+    s->next = c->partial;
+    if (c->partial) c->partial->prev = s;
+    c->partial = s;
+}
+
+static void partial_remove(Cache* c, Slab* s) {
+    if (s->prev) s->prev->next = s->next;
+    else c->partial = s->next;
+    if (s->next) s->next->prev = s->prev;
+}
+
+static Slab* slab_new(int cls) {
+    Slab* s = (Slab*)pmm_alloc(PAGE_SIZE);
+    if (!s) return 0;
+
+    uint32_t size = kmalloc_stats[cls].size;
+    s->magic = SLAB_MAGIC;
+    s->cls = (uint16_t)cls;
+    s->in_use = 0;
+    s->free = 0;
+
+    // Thread the list back to front so it hands out ascending addresses
+    uint32_t count = (PAGE_SIZE - SLAB_OBJ_START) / size;
+    uint8_t* base = (uint8_t*)s + SLAB_OBJ_START;
+    for (uint32_t i = count; i-- > 0;) {
+        void** obj = (void**)(base + i * size);
+        *obj = s->free;
+        s->free = obj;
+    }
+
+    kmalloc_stats[cls].slabs++;
+    caches[cls].empty++;
+    partial_push(&caches[cls], s);
+    return s;
+}
+
+// --- Allocation ---
+static void* large_alloc(uint32_t size) {
+    uint32_t pages = (size + sizeof(LargeHeader) + PAGE_SIZE - 1) / PAGE_SIZE;
+    LargeHeader* h = (LargeHeader*)pmm_alloc(pages * PAGE_SIZE);
+    if (!h) return 0;
+    h->magic = LARGE_MAGIC;
+    h->pages = pages;
+    kmalloc_large_live++;
+    kmalloc_large_pages += pages;
+    return h + 1;
+}
+
+void* kmalloc(uint32_t size) {
+    if (!size) return 0;
+
+    void* p;
+    if (size > KMALLOC_MAX_SMALL) {
+        p = large_alloc(size);
+    } else {
+        int cls = size_class(size);
+        Cache* c = &caches[cls];
+        Slab* s = c->partial;
+        if (!s) s = slab_new(cls);
+        if (s) {
+            if (!s->in_use) c->empty--;
+            p = s->free;
+            s->free = *(void**)p;
+            s->in_use++;
+            if (!s->free) partial_remove(c, s);
+            kmalloc_stats[cls].in_use++;
+            kmalloc_stats[cls].allocs++;
+        } else {
+            p = 0;
+        }
+    }
+
+    if (!p) kmalloc_failures++;
+    return p;
+}
+
+void* kzalloc(uint32_t size) {
+    void* p = kmalloc(size);
+    if (p) k_memset(p, 0, size);
+    return p;
+}
+
+// Bytes the caller may use in a live block
+static uint32_t usable_size(void* ptr) {
+    Slab* s = (Slab*)((uint32_t)ptr & ~(PAGE_SIZE - 1));
+    if (s->magic == SLAB_MAGIC) return kmalloc_stats[s->cls].size;
+    LargeHeader* h = (LargeHeader*)s;
+    return h->pages * PAGE_SIZE - sizeof(LargeHeader);
+}
+
+void* krealloc(void* ptr, uint32_t size) {
+    if (!ptr) return kmalloc(size);
+    if (!size) {
+        kfree(ptr);
+        return 0;
+    }
+
+    uint32_t old = usable_size(ptr);
+    if (size <= old) return ptr;
+
+    void* p = kmalloc(size);
+    if (!p) return 0;
+    k_memcpy(p, ptr, old);
+    kfree(ptr);
+    return p;
+}
+
+void kfree(void* ptr) {
+    if (!ptr) return;
+
+    Slab* s = (Slab*)((uint32_t)ptr & ~(PAGE_SIZE - 1));
+    if (s->magic == LARGE_MAGIC && (uint32_t)ptr == (uint32_t)s + sizeof(LargeHeader)) {
+        LargeHeader* h = (LargeHeader*)s;
+        uint32_t pages = h->pages;
+        h->magic = 0;
+        kmalloc_large_live--;
+        kmalloc_large_pages -= pages;
+        pmm_free((uint32_t)h, pages * PAGE_SIZE);
+        return;
+    }
+    if (s->magic != SLAB_MAGIC) return;
+
+    int cls = s->cls;
+    Cache* c = &caches[cls];
+    if (!s->free) partial_push(c, s); // Was full
+    *(void**)ptr = s->free;
+    s->free = ptr;
+    s->in_use--;
+    kmalloc_stats[cls].in_use--;
+    kmalloc_stats[cls].frees++;
+
+    if (s->in_use) return;
+
+    // Keep one empty slab per class so a free/alloc pair at the edge
+    // doesn't bounce a page in and out of the page allocator
+    if (c->empty) {
+        partial_remove(c, s);
+        s->magic = 0;
+        kmalloc_stats[cls].slabs--;
+        pmm_free((uint32_t)s, PAGE_SIZE);
+    } else {
+        c->empty++;
+    }
+}
+
+// --- Report ---
+static char* append(char* dst, const char* src) {
+    while (*src) *dst++ = *src++;
+    *dst = 0;
+    return dst;
+}
+
+static char* append_u32(char* dst, uint32_t v) {
+    char tmp[12];
+    int n = 0;
+    do { tmp[n++] = '0' + (v % 10); v /= 10; } while (v);
+    while (n) *dst++ = tmp[--n];
+    *dst = 0;
+    return dst;
+}
+
+void kmalloc_report(void (*print)(const char*)) {
+    char line[80];
+    char* p = append(line, "Pages: ");
+    p = append_u32(p, pmm_free_pages);
+    p = append(p, " free of ");
+    p = append_u32(p, pmm_total_pages);
+    p = append(p, " (");
+    p = append_u32(p, pmm_total_pages / 256);
+    p = append(p, " MB)");
+    print(line);
+
+    for (int i = 0; i < KMALLOC_CLASSES; i++) {
+        KmallocCacheStats* st = &kmalloc_stats[i];
+        p = append(line, "kmalloc-");
+        p = append_u32(p, st->size);
+        p = append(p, ": ");
+        p = append_u32(p, st->in_use);
+        p = append(p, " live, ");
+        p = append_u32(p, st->slabs);
+        p = append(p, " slabs, ");
+        p = append_u32(p, st->allocs);
+        p = append(p, " allocs, ");
+        p = append_u32(p, st->frees);
+        p = append(p, " frees");
+        print(line);
+    }
+
+    p = append(line, "Large: ");
+    p = append_u32(p, kmalloc_large_live);
+    p = append(p, " live, ");
+    p = append_u32(p, kmalloc_large_pages);
+    p = append(p, " pages; ");
+    p = append_u32(p, kmalloc_failures);
+    p = append(p, " failed");
+    print(line);
+}
@@ -0,0 +1,41 @@
+#ifndef KMALLOC_H
+#define KMALLOC_H
+
+#include <stdint.h>
+
+// --- Kernel Heap ---
+// Requests up to KMALLOC_MAX_SMALL bytes come from per-size-class slab
+// caches. A slab is one page of same-sized objects threaded on a free
+// list, so alloc and free are a few pointer moves. Larger requests get
+// whole pages from the page allocator. Nothing here may be called from
+// an interrupt handler.
+
+#define KMALLOC_CLASSES   7      // 16, 32, ... 1024 bytes
+#define KMALLOC_MAX_SMALL 1024
+
+typedef struct {
+    uint32_t size;      // object size of the class
+    uint32_t slabs;     // pages held, including the spare empty one
+    uint32_t in_use;    // live objects
+    uint32_t allocs;    // since boot
+    uint32_t frees;
+} KmallocCacheStats;
+
+extern KmallocCacheStats kmalloc_stats[KMALLOC_CLASSES];
+extern uint32_t kmalloc_large_live;    // live page-backed allocations
+extern uint32_t kmalloc_large_pages;
+extern uint32_t kmalloc_failures;
+
+void* kmalloc(uint32_t size);
+void* kzalloc(uint32_t size);
+
+// Grows in place while the block has room, otherwise moves it.
+// Returns 0 and leaves the old block alone when out of memory.
+void* krealloc(void* ptr, uint32_t size);
+
+void kfree(void* ptr);
+
+// One line per size class plus the large allocations and page totals
+void kmalloc_report(void (*print)(const char*));
+
+#endif
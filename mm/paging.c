@@ -0,0 +1,280 @@
+#include "paging.h"
+#include "pmm.h"
+#include "../drivers/cpu.h"
+
+#define PG_PRESENT 0x001
+#define PG_WRITE   0x002
+#define PG_PWT     0x008
+#define PG_PCD     0x010
+#define PG_LARGE   0x080   // PDE only: maps 4 MiB directly
+#define PG_GLOBAL  0x100
+
+#define LARGE_SIZE 0x400000
+#define LARGE_MASK (LARGE_SIZE - 1)
+
+#define CR0_PG  (1u << 31)
+#define CR4_PSE (1u << 4)
+#define CR4_PGE (1u << 7)
+
+// Power-on PAT with PA1 turned from write-through into write-combining,
+// so PWT alone selects WC and PCD|PWT stays UC
+#define MSR_PAT   0x277
+#define PAT_VALUE 0x0007040600070106ULL
+
+#define MAX_REGIONS 32
+
+typedef struct {
+    uint32_t base;
+    uint32_t last;      // inclusive, so a region can end at 4 GiB
+    int type;
+    const char* name;
+    uint32_t large;     // 4 MiB pages this region was given
+    uint32_t small;     // 4 KiB pages
+} Region;
+
+int paging_enabled = 0;
+
+static uint32_t page_dir[1024] __attribute__((aligned(4096)));
+static Region regions[MAX_REGIONS];
+static int region_count;
+static int use_pse, use_pat, use_pge;
+static uint32_t table_failures;
+
+static const char* type_names[] = { "WB", "WC", "UC" };
+
+static uint32_t type_bits(int type) {
+    if (type == MEM_UC) return PG_PCD | PG_PWT;
+    // Without PAT the MTRR set up for the framebuffer decides WC, and
+    // write-back page bits let it through unchanged
+    if (type == MEM_WC && use_pat) return PG_PWT;
+    return 0;
+}
+
+static uint32_t entry_bits(int type) {
+    return PG_PRESENT | PG_WRITE | type_bits(type) | (use_pge ? PG_GLOBAL : 0);
+}
+
+// Page table for directory slot `pdi`, splitting a large page into 1024
+// small ones with the same type. 0 when out of memory.
+static uint32_t* table_for(uint32_t pdi) {
+    uint32_t pde = page_dir[pdi];
+    if ((pde & PG_PRESENT) && !(pde & PG_LARGE)) return (uint32_t*)(pde & ~0xFFFu);
+
+    uint32_t* pt = (uint32_t*)pmm_alloc(PAGE_SIZE);
+    if (!pt) {
+        table_failures++;
+        return 0;
+    }
+    // The cache and global bits sit at the same place in both entries
+    uint32_t base = pde & ~LARGE_MASK;
+    uint32_t flags = pde & 0xFFF & ~PG_LARGE;
+    for (uint32_t i = 0; i < 1024; i++) {
+        pt[i] = (pde & PG_PRESENT) ? (base + i * PAGE_SIZE) | flags : 0;
+    }
+    page_dir[pdi] = (uint32_t)pt | PG_PRESENT | PG_WRITE;
+    return pt;
+}
+
+static void apply(Region* r) {
+    uint32_t bits = entry_bits(r->type);
+    uint32_t addr = r->base & ~0xFFFu;
+
+    for (;;) {
+        uint32_t pdi = addr >> 22;
+        uint32_t block_last = addr | LARGE_MASK;
+        uint32_t end = r->last < block_last ? r->last : block_last;
+
+        if (use_pse && !(addr & LARGE_MASK) && end == block_last) {
+            uint32_t pde = page_dir[pdi];
+            if ((pde & PG_PRESENT) && !(pde & PG_LARGE)) pmm_free(pde & ~0xFFFu, PAGE_SIZE);
+            page_dir[pdi] = addr | bits | PG_LARGE;
+            r->large++;
+        } else {
+            uint32_t* pt = table_for(pdi);
+            if (!pt) return;
+            for (uint32_t a = addr; ; a += PAGE_SIZE) {
+                pt[(a >> 12) & 1023] = a | bits;
+                r->small++;
+                if (a >= (end & ~0xFFFu)) break;
+            }
+        }
+
+        if (end == r->last) return;
+        addr = end + 1;
+    }
+}
+
+static void flush_tlb(void) {
+    uint32_t cr;
+    if (use_pge) {
+        // Global entries survive a CR3 reload, toggling PGE drops them
+        asm volatile("mov %%cr4, %0" : "=r"(cr));
+        asm volatile("mov %0, %%cr4" : : "r"(cr & ~CR4_PGE) : "memory");
+        asm volatile("mov %0, %%cr4" : : "r"(cr) : "memory");
+    } else {
+        asm volatile("mov %%cr3, %0" : "=r"(cr));
+        asm volatile("mov %0, %%cr3" : : "r"(cr) : "memory");
+    }
+}
+
+static void add_region(uint32_t base, uint32_t last, int type, const char* name) {
+    if (region_count >= MAX_REGIONS) return;
+
+    Region* r = &regions[region_count++];
+    r->base = base;
+    r->last = last;
+    r->type = type;
+    r->name = name;
+    r->large = 0;
+    r->small = 0;
+    apply(r);
+
+    if (paging_enabled) {
+        asm volatile("wbinvd" : : : "memory");
+        flush_tlb();
+    }
+}
+
+void paging_init(void) {
+    use_pse = cpu_has(CPU_FEAT_PSE);
+    use_pat = cpu_has(CPU_FEAT_PAT) && cpu_has(CPU_FEAT_MSR);
+    use_pge = cpu_has(CPU_FEAT_PGE);
+
+    for (int i = 0; i < 1024; i++) page_dir[i] = 0;
+    region_count = 0;
+    table_failures = 0;
+
+    // Everything starts uncached and only what the map calls RAM becomes
+    // write-back, so holes, firmware areas and the PCI window below 4 GiB
+    // never depend on the firmware's MTRRs. Without PSE that would take a
+    // page table per 4 MiB, so the base only reaches the top of RAM.
+    uint32_t ram_top = 0x100000 >> 12;
+    for (int i = 0; i < pmm_ram_range_count; i++) {
+        const PmmRange* r = &pmm_ram_ranges[i];
+        if (r->page + r->count > ram_top) ram_top = r->page + r->count;
+    }
+    if (use_pse) {
+        add_region(0, 0xFFFFFFFF, MEM_UC, "Device space");
+    } else {
+        add_region(0, ram_top * PAGE_SIZE - 1, MEM_UC, "Not RAM");
+    }
+    for (int i = 0; i < pmm_ram_range_count; i++) {
+        const PmmRange* r = &pmm_ram_ranges[i];
+        add_region(r->page * PAGE_SIZE, (r->page + r->count) * PAGE_SIZE - 1, MEM_WB, "RAM");
+    }
+    add_region(0xA0000, 0xBFFFF, MEM_UC, "Legacy VGA");
+}
+
+void paging_map(uint32_t base, uint32_t size, int type, const char* name) {
+    if (!size) return;
+    uint32_t last = base + (size - 1);
+    if (last < base) last = 0xFFFFFFFF;
+    add_region(base, last, type, name);
+}
+
+void paging_enable(void) {
+    if (use_pat) {
+        asm volatile("wbinvd" : : : "memory");
+        wrmsr(MSR_PAT, PAT_VALUE);
+    }
+
+    if (use_pse || use_pge) {
+        uint32_t cr4;
+        asm volatile("mov %%cr4, %0" : "=r"(cr4));
+        if (use_pse) cr4 |= CR4_PSE;
+        if (use_pge) cr4 |= CR4_PGE;
+        asm volatile("mov %0, %%cr4" : : "r"(cr4));
+    }
+
+    uint32_t cr0;
+    asm volatile("mov %0, %%cr3" : : "r"(page_dir) : "memory");
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    asm volatile("mov %0, %%cr0" : : "r"(cr0 | CR0_PG) : "memory");
+    paging_enabled = 1;
+}
+
+// --- Report ---
+
+static char* append(char* dst, const char* src) {
+    while (*src) *dst++ = *src++;
+    *dst = '\0';
+    return dst;
+}
+
+static char* append_u32(char* dst, uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do { tmp[n++] = '0' + v % 10; v /= 10; } while (v);
+    while (n) *dst++ = tmp[--n];
+    *dst = '\0';
+    return dst;
+}
+
+static char* append_hex(char* dst, uint32_t v) {
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        *dst++ = "0123456789ABCDEF"[(v >> shift) & 0xF];
+    }
+    *dst = '\0';
+    return dst;
+}
+
+void paging_report(void (*print)(const char*)) {
+    char line[80];
+    char* p = append(line, "Paging: ");
+    p = append(p, paging_enabled ? "on" : "off");
+    p = append(p, use_pse ? ", 4M pages" : ", 4K pages only");
+    p = append(p, use_pat ? ", PAT" : ", no PAT (WC from MTRR)");
+    if (use_pge) p = append(p, ", global");
+    print(line);
+
+    for (int i = 0; i < region_count; i++) {
+        Region* r = &regions[i];
+        p = append_hex(line, r->base);
+        p = append(p, "-");
+        p = append_hex(p, r->last);
+        p = append(p, " ");
+        p = append(p, type_names[r->type]);
+        p = append(p, " ");
+        p = append(p, r->name);
+        p = append(p, ": ");
+        if (r->large) {
+            p = append_u32(p, r->large);
+            p = append(p, " x 4M");
+            if (r->small) p = append(p, ", ");
+        }
+        if (r->small || !r->large) {
+            p = append_u32(p, r->small);
+            p = append(p, " x 4K");
+        }
+        print(line);
+    }
+
+    // What the directory holds now, after later regions split earlier ones
+    uint32_t large = 0, tables = 0, small = 0;
+    for (int i = 0; i < 1024; i++) {
+        uint32_t pde = page_dir[i];
+        if (!(pde & PG_PRESENT)) continue;
+        if (pde & PG_LARGE) {
+            large++;
+            continue;
+        }
+        tables++;
+        uint32_t* pt = (uint32_t*)(pde & ~0xFFFu);
+        for (int j = 0; j < 1024; j++) {
+            if (pt[j] & PG_PRESENT) small++;
+        }
+    }
+    p = append(line, "Directory: ");
+    p = append_u32(p, large);
+    p = append(p, " x 4M, ");
+    p = append_u32(p, tables);
+    p = append(p, " tables with ");
+    p = append_u32(p, small);
+    p = append(p, " x 4K");
+    if (table_failures) {
+        p = append(p, "; ");
+        p = append_u32(p, table_failures);
+        p = append(p, " tables failed");
+    }
+    print(line);
+}
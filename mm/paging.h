@@ -0,0 +1,35 @@
+#ifndef PAGING_H
+#define PAGING_H
+
+#include <stdint.h>
+
+// --- Paging ---
+// Everything stays identity mapped, so physical addresses from the page
+// allocator and PCI BARs keep working as pointers. Paging is only there
+// to give each region a memory type: RAM is write-back in 4 MiB PSE
+// pages, and a 4 MiB block is split into 4 KiB pages only where a region
+// with a different type starts or ends inside it. On a 486 (no PSE)
+// RAM and the listed regions are mapped with 4 KiB pages instead.
+
+#define MEM_WB 0   // write-back, ordinary RAM
+#define MEM_WC 1   // write-combining, framebuffers
+#define MEM_UC 2   // uncached, device registers
+
+extern int paging_enabled;
+
+// Build the tables: each pmm_ram_ranges entry write-back, the legacy VGA
+// window and every other address uncached (without PSE only up to the top
+// of RAM). Needs the page allocator.
+void paging_init(void);
+
+// Map [base, base + size) with the given type. Later calls win where
+// regions overlap. Once paging is on the TLB is flushed as well.
+void paging_map(uint32_t base, uint32_t size, int type, const char* name);
+
+// Load PAT, CR4, CR3 and set CR0.PG on the calling CPU
+void paging_enable(void);
+
+// Feature line, one line per region and the directory totals
+void paging_report(void (*print)(const char*));
+
+#endif
@@ -0,0 +1,174 @@
+#include "pmm.h"
+
+// Set by linker.ld around everything GRUB loads for us, .bss included
+extern uint8_t kernel_start[];
+extern uint8_t kernel_end[];
+
+#define PMM_MAX_PAGES (1u << 20)   // 4 GiB
+
+// Multiboot memory map entry; `size` does not count itself
+struct mmap_entry {
+    uint32_t size;
+    uint64_t addr;
+    uint64_t len;
+    uint32_t type;
+} __attribute__((packed));
+
+#define MMAP_AVAILABLE 1
+#define MMAP_ACPI      3
+#define MMAP_NVS       4
+
+uint32_t pmm_total_pages = 0;
+uint32_t pmm_free_pages = 0;
+PmmRange pmm_ram_ranges[PMM_MAX_RANGES];
+int pmm_ram_range_count = 0;
+
+static uint32_t bitmap[PMM_MAX_PAGES / 32];
+static uint32_t page_limit;   // one past the highest RAM page
+static uint32_t first_free;   // no free page below this
+
+static inline int page_used(uint32_t page) {
+    return (bitmap[page >> 5] >> (page & 31)) & 1;
+}
+
+static void mark_used(uint32_t page, uint32_t count) {
+    for (uint32_t p = page; p < page + count && p < PMM_MAX_PAGES; p++) {
+        if (page_used(p)) continue;
+        bitmap[p >> 5] |= 1u << (p & 31);
+        pmm_free_pages--;
+    }
+}
+
+static void mark_free(uint32_t page, uint32_t count) {
+    for (uint32_t p = page; p < page + count && p < PMM_MAX_PAGES; p++) {
+        if (!page_used(p)) continue;
+        bitmap[p >> 5] &= ~(1u << (p & 31));
+        pmm_free_pages++;
+    }
+    if (page < first_free) first_free = page;
+    if (page + count > page_limit) page_limit = page + count;
+}
+
+// Pages touching [base, base + size), clipped at 4 GiB
+static void byte_range(uint64_t base, uint64_t size, uint32_t* page, uint32_t* count) {
+    uint64_t end = base + size;
+    if (end > (uint64_t)PMM_MAX_PAGES * PAGE_SIZE) end = (uint64_t)PMM_MAX_PAGES * PAGE_SIZE;
+    uint32_t first = (uint32_t)(base >> 12);
+    uint32_t last = (uint32_t)((end + PAGE_SIZE - 1) >> 12);
+    *page = first;
+    *count = (base < end) ? last - first : 0;
+}
+
+// Add [page, page + count) to pmm_ram_ranges, folding in every range it
+// overlaps or touches. A map with more separate ranges than fit loses the
+// extra ones, which then just stay uncached.
+static void add_ram_range(uint32_t page, uint32_t count) {
+    if (!count) return;
+    uint32_t end = page + count;
+
+    for (int i = 0; i < pmm_ram_range_count; ) {
+        PmmRange* r = &pmm_ram_ranges[i];
+        if (r->page > end || r->page + r->count < page) {
+            i++;
+            continue;
+        }
+        if (r->page < page) page = r->page;
+        if (r->page + r->count > end) end = r->page + r->count;
+        *r = pmm_ram_ranges[--pmm_ram_range_count];
+        // The grown range may now reach one already passed
+        i = 0;
+    }
+    if (pmm_ram_range_count >= PMM_MAX_RANGES) return;
+    pmm_ram_ranges[pmm_ram_range_count].page = page;
+    pmm_ram_ranges[pmm_ram_range_count].count = end - page;
+    pmm_ram_range_count++;
+}
+
+void pmm_init(uint32_t mmap_addr, uint32_t mmap_length, uint32_t mem_upper_kb) {
+    for (uint32_t i = 0; i < PMM_MAX_PAGES / 32; i++) bitmap[i] = 0xFFFFFFFF;
+    pmm_free_pages = 0;
+    page_limit = 0;
+    first_free = PMM_MAX_PAGES;
+    pmm_ram_range_count = 0;
+
+    uint32_t page, count;
+    if (mmap_length) {
+        uint32_t p = mmap_addr;
+        while (p < mmap_addr + mmap_length) {
+            struct mmap_entry* e = (struct mmap_entry*)p;
+            // Only whole pages of available RAM; partial ones stay used
+            if (e->type == MMAP_AVAILABLE && e->len >= PAGE_SIZE) {
+                uint64_t start = (e->addr + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1);
+                uint64_t end = (e->addr + e->len) & ~(uint64_t)(PAGE_SIZE - 1);
+                if (end > start) {
+                    byte_range(start, end - start, &page, &count);
+                    mark_free(page, count);
+                }
+            }
+            if (e->type == MMAP_AVAILABLE || e->type == MMAP_ACPI || e->type == MMAP_NVS) {
+                byte_range(e->addr, e->len, &page, &count);
+                add_ram_range(page, count);
+            }
+            p += e->size + 4;
+        }
+    } else {
+        // Conventional memory and the block above 1 MiB
+        mark_free(0x100000 >> 12, mem_upper_kb / 4);
+        add_ram_range(0, 0xA0000 >> 12);
+        add_ram_range(0x100000 >> 12, mem_upper_kb / 4);
+    }
+    pmm_total_pages = pmm_free_pages;
+
+    // BIOS data, the multiboot structures GRUB left there, option ROMs
+    mark_used(0, 0x100000 >> 12);
+    pmm_reserve((uint32_t)kernel_start, (uint32_t)(kernel_end - kernel_start));
+}
+
+void pmm_reserve(uint32_t base, uint32_t size) {
+    uint32_t page, count;
+    byte_range(base, size, &page, &count);
+    mark_used(page, count);
+}
+
+int pmm_claim(uint32_t base, uint32_t size) {
+    uint32_t page, count;
+    byte_range(base, size, &page, &count);
+    if (!count || page + count > page_limit) return 0;
+    for (uint32_t p = page; p < page + count; p++) {
+        if (page_used(p)) return 0;
+    }
+    mark_used(page, count);
+    return 1;
+}
+
+uint32_t pmm_alloc(uint32_t size) {
+    uint32_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (!pages || pages > pmm_free_pages) return 0;
+
+    uint32_t run = 0;
+    for (uint32_t p = first_free; p < page_limit; p++) {
+        // Skip fully used words a word at a time
+        if (!(p & 31) && bitmap[p >> 5] == 0xFFFFFFFF) {
+            run = 0;
+            p += 31;
+            continue;
+        }
+        if (page_used(p)) {
+            run = 0;
+            continue;
+        }
+        if (++run < pages) continue;
+
+        uint32_t start = p + 1 - pages;
+        mark_used(start, pages);
+        while (first_free < page_limit && page_used(first_free)) first_free++;
+        return start * PAGE_SIZE;
+    }
+    return 0;
+}
+
+void pmm_free(uint32_t base, uint32_t size) {
+    uint32_t page, count;
+    byte_range(base, size, &page, &count);
+    mark_free(page, count);
+}
@@ -0,0 +1,48 @@
+#ifndef PMM_H
+#define PMM_H
+
+#include <stdint.h>
+
+// --- Physical Memory Manager ---
+// One bit per 4 KiB page frame below 4 GiB, set while the frame is in
+// use. It is built from the multiboot memory map, and anything the map
+// does not list as available RAM stays marked used. Memory is identity
+// mapped, so the addresses handed out are usable pointers as they are.
+
+#define PAGE_SIZE 4096
+
+// Usable RAM the firmware reported, and what is still unallocated
+extern uint32_t pmm_total_pages;
+extern uint32_t pmm_free_pages;
+
+// RAM the map lists below 4 GiB, ACPI tables and NVS included, in pages
+// and merged where entries touch. Paging maps these as ordinary memory
+// and everything else as uncached.
+#define PMM_MAX_RANGES 16
+
+typedef struct {
+    uint32_t page;
+    uint32_t count;
+} PmmRange;
+
+extern PmmRange pmm_ram_ranges[PMM_MAX_RANGES];
+extern int pmm_ram_range_count;
+
+// mmap_addr/mmap_length as multiboot passes them. Without a map
+// (mmap_length 0) the mem_upper_kb block above 1 MiB is used instead.
+// The first megabyte and the kernel image come out reserved.
+void pmm_init(uint32_t mmap_addr, uint32_t mmap_length, uint32_t mem_upper_kb);
+
+// Mark a byte range used, e.g. boot modules. Parts that are not RAM are
+// ignored.
+void pmm_reserve(uint32_t base, uint32_t size);
+
+// Take a fixed byte range. Fails (returns 0) unless all of it is free RAM.
+int pmm_claim(uint32_t base, uint32_t size);
+
+// Lowest run of free frames covering `size` bytes; 0 if there is none
+uint32_t pmm_alloc(uint32_t size);
+
+void pmm_free(uint32_t base, uint32_t size);
+
+#endif
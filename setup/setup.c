@@ -5,6 +5,7 @@
 #include "../drivers/pci.h"
 #include "../drivers/ahci.h"
 #include "../drivers/cdfs.h"
+#include "../mm/pmm.h"
 
 /* ===== I/O Port Access ===== */
 static inline void outb(uint16_t port, uint8_t val) {
@@ -1137,6 +1138,11 @@ void kernel_main(uint32_t magic, struct multiboot_info* mbd) {
     idt_install();
     mouse_install();
 
+    /* Page allocator first: the AHCI driver takes its port memory from it.
+       Setup is booted without modules, so there is nothing else to reserve. */
+    pmm_init(mbd->mmap_addr, (mbd->flags & (1 << 6)) ? mbd->mmap_length : 0,
+             (mbd->flags & 1) ? mbd->mem_upper : 15 * 1024);
+
     uint32_t total_mem = 0;
     /* Framebuffer setup */
     if (mbd->flags & (1 << 12)) {
@@ -1150,11 +1156,8 @@ void kernel_main(uint32_t magic, struct multiboot_info* mbd) {
         else total_mem = 16 * 1024 * 1024;
 
         uint32_t bb_size = scr_height * pitch;
-        uint32_t bb_start = (0x400000 + 0x10000 + 0xFFF) & ~0xFFF;
-
-        if (bb_start + bb_size <= total_mem)
-            backbuffer = (uint32_t*)bb_start;
-        else
+        backbuffer = (uint32_t*)pmm_alloc(bb_size);
+        if (!backbuffer)
             backbuffer = fb;
     }
     /* Enable animations if RAM >= 64MB and CPU is Pentium or newer */